@@ -0,0 +1,621 @@
+/*Projet Huffman - Compression et Décompression de fichiers en C
+Auteur : Rosselle QUIZON
+Description du code : Mesure les performances de la bibliothèque huffman.c sur des données synthétiques ou sur des fichiers :
+débit de la compression et de la décompression, taux de compression, taille des en-têtes, durée de chaque phase et mémoire utilisée*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "huffman.c" //les phases sont chronométrées séparément avec les fonctions internes de la bibliothèque
+
+#define TAILLE_DEFAUT ((size_t)8 << 20) //taille des données synthétiques par défaut
+#define ESSAIS_DEFAUT 5 //chaque mesure garde le meilleur des essais
+
+//phases chronométrées séparément, sur chaque bloc de l'entrée
+#define PHASE_HISTOGRAMME 0
+#define PHASE_ARBRE 1
+#define PHASE_CODES 2
+#define PHASE_CODAGE 3
+#define PHASE_TABLES 4
+#define PHASE_DECODAGE 5
+#define NB_PHASES 6
+
+static const char *noms_phases[NB_PHASES] = {"histogramme", "arbre", "codes", "codage", "tables", "decodage"};
+
+//structure représentant un jeu de données mesuré
+typedef struct {
+	char nom[256];
+	uint8_t *donnees;
+	size_t taille;
+} jeu;
+
+//structure pour stocker les mesures d'un jeu de données, les durées sont en secondes
+typedef struct {
+	double compression;
+	double decompression;
+	double phases[NB_PHASES];
+	size_t taille_compressee;
+	size_t en_tetes; //octets qui ne sont pas des données codées : en-têtes, tables, index et pied
+	long rss_max; //pic de mémoire du processus en Ko
+} mesures;
+
+double maintenant(void);
+uint64_t aleatoire(uint64_t *etat);
+void generer(jeu *j, const char *nom, size_t taille);
+void charger_fichier(jeu *j, const char *fichier);
+size_t taille_en_tetes(const uint8_t *src, size_t taille);
+void mesurer_phases(const jeu *j, const huff_options *o, mesures *m);
+void mesurer(const jeu *j, const huff_options *o, int essais, mesures *m);
+void afficher(const jeu *j, const mesures *m, int json, int premier);
+void mesurer_histogramme(const jeu *j, int essais, double debits[2]);
+
+int main(int argc, char *argv[])
+{
+    	huff_options o;
+    	huff_options_defaut(&o);
+    	size_t taille = TAILLE_DEFAUT;
+    	int essais = ESSAIS_DEFAUT;
+    	int json = 0;
+    	int histogramme = 0;
+    	int a = 1;
+    	while (a < argc && strncmp(argv[a], "--", 2) == 0)
+    	{
+    		if ((strcmp(argv[a], "--size") == 0 || strcmp(argv[a], "--block-size") == 0) && a + 1 < argc)
+    		{
+    			char *fin;
+    			size_t n = strtoull(argv[a + 1], &fin, 10);
+    			if (*fin == 'K' || *fin == 'k') //suffixes K et M pour les kibioctets et les mébioctets
+    			{
+    				n <<= 10;
+    			}
+    			else if (*fin == 'M' || *fin == 'm')
+    			{
+    				n <<= 20;
+    			}
+    			if (strcmp(argv[a], "--size") == 0)
+    			{
+    				taille = n;
+    			}
+    			else
+    			{
+    				o.taille_bloc = n;
+    			}
+    			a += 2;
+    		}
+    		else if (strcmp(argv[a], "--max-code-len") == 0 && a + 1 < argc)
+    		{
+    			o.lg_max = atoi(argv[a + 1]);
+    			a += 2;
+    		}
+    		else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc)
+    		{
+    			o.nb_threads = atoi(argv[a + 1]);
+    			a += 2;
+    		}
+    		else if (strcmp(argv[a], "--streams") == 0 && a + 1 < argc)
+    		{
+    			o.nb_flux = atoi(argv[a + 1]);
+    			a += 2;
+    		}
+    		else if (strcmp(argv[a], "--order") == 0 && a + 1 < argc)
+    		{
+    			o.ordre = atoi(argv[a + 1]);
+    			a += 2;
+    		}
+    		else if (strcmp(argv[a], "--rle") == 0)
+    		{
+    			o.plages = 1;
+    			a++;
+    		}
+    		else if (strcmp(argv[a], "--iterations") == 0 && a + 1 < argc)
+    		{
+    			essais = atoi(argv[a + 1]);
+    			a += 2;
+    		}
+    		else if (strcmp(argv[a], "--json") == 0)
+    		{
+    			json = 1;
+    			a++;
+    		}
+    		else if (strcmp(argv[a], "--histogram") == 0)
+    		{
+    			histogramme = 1;
+    			a++;
+    		}
+    		else
+    		{
+        		fprintf(stderr, "Erreur : option inconnue %s\n", argv[a]);
+        		fprintf(stderr, "Usage: %s [--size N[K|M]] [--block-size N[K|M]] [--max-code-len N] [--threads N] [--streams 1|4] [--order 0|1] [--rle] [--iterations N] [--histogram] [--json] [fichier...]\n", argv[0]);
+        		return EXIT_FAILURE;
+    		}
+    	}
+    	if (!options_valides(&o) || o.lg_max < 8 || essais < 1 || taille == 0) //les phases codent tous les blocs : 256 caractères doivent tenir dans lg_max bits
+    	{
+		fprintf(stderr, "Erreur : %s.\n", huff_erreur(HUFF_ERREUR_PARAMETRE));
+		return EXIT_FAILURE;
+    	}
+
+    	//sans fichier, on mesure les distributions synthétiques
+    	static const char *synthetiques[] = {"uniforme", "zipf", "constant", "fibonacci", "texte", "aleatoire", "plages"};
+    	int nb_jeux = a < argc ? argc - a : (int)(sizeof(synthetiques) / sizeof(synthetiques[0]));
+    	if (histogramme) //seulement le comptage des caractères : noyau scalaire contre noyau choisi pour ce processeur
+    	{
+    		const char *nom_noyau = choisir_histogramme() == histogramme_bloc ? "scalaire" : "avx2";
+    		if (json)
+    		{
+    			printf("{\"noyau\": \"%s\", \"essais\": %d, \"resultats\": [\n", nom_noyau, essais);
+    		}
+    		else
+    		{
+    			printf("%-24s %12s %14s %14s %8s   (noyau choisi : %s)\n", "jeu", "taille", "scalaire MB/s", "noyau MB/s", "gain", nom_noyau);
+    		}
+    		for (int i = 0; i < nb_jeux; i++)
+    		{
+    			jeu j;
+    			if (a < argc)
+    			{
+    				charger_fichier(&j, argv[a + i]);
+    			}
+    			else
+    			{
+    				generer(&j, synthetiques[i], taille);
+    			}
+    			double debits[2];
+    			mesurer_histogramme(&j, essais, debits);
+    			if (json)
+    			{
+    				printf("%s  {\"nom\": \"%s\", \"taille\": %zu, \"scalaire_mo_s\": %.1f, \"noyau_mo_s\": %.1f}", i == 0 ? "" : ",\n", j.nom, j.taille, debits[0], debits[1]);
+    			}
+    			else
+    			{
+    				printf("%-24s %12zu %14.1f %14.1f %7.2fx\n", j.nom, j.taille, debits[0], debits[1], debits[1] / debits[0]);
+    			}
+    			fflush(stdout);
+    			free(j.donnees);
+    		}
+    		if (json)
+    		{
+    			printf("\n]}\n");
+    		}
+    		return EXIT_SUCCESS;
+    	}
+    	if (json)
+    	{
+    		printf("{\"taille_bloc\": %zu, \"lg_max\": %d, \"threads\": %d, \"flux\": %d, \"ordre\": %d, \"plages\": %d, \"essais\": %d, \"resultats\": [\n", o.taille_bloc, o.lg_max, o.nb_threads, o.nb_flux, o.ordre, o.plages, essais);
+    	}
+    	else
+    	{
+    		printf("%-24s %12s %8s %10s %10s %10s %8s   ns/octet par phase (histogramme arbre codes codage tables decodage)\n", "jeu", "taille", "ratio", "en-tetes", "comp MB/s", "dec MB/s", "rss Ko");
+    	}
+    	for (int i = 0; i < nb_jeux; i++)
+    	{
+    		jeu j;
+    		if (a < argc)
+    		{
+    			charger_fichier(&j, argv[a + i]);
+    		}
+    		else
+    		{
+    			generer(&j, synthetiques[i], taille);
+    		}
+    		mesures m;
+    		mesurer(&j, &o, essais, &m);
+    		afficher(&j, &m, json, i == 0);
+    		free(j.donnees);
+    	}
+    	if (json)
+    	{
+    		printf("\n]}\n");
+    	}
+    	return EXIT_SUCCESS;
+}
+
+//fonction qui renvoie le temps écoulé en secondes depuis un instant fixe
+double maintenant(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+//fonction qui renvoie un nombre pseudo-aléatoire de 64 bits (xorshift64*) : les données synthétiques sont les mêmes à chaque exécution
+uint64_t aleatoire(uint64_t *etat)
+{
+	*etat ^= *etat >> 12;
+	*etat ^= *etat << 25;
+	*etat ^= *etat >> 27;
+	return *etat * 2685821657736338717ull;
+}
+
+//fonction pour générer des données synthétiques selon une distribution :
+//uniforme (16 caractères équiprobables), zipf (caractère de rang k avec une probabilité en 1/k), constant (un seul caractère),
+//fibonacci (poids des caractères en suite de Fibonacci, l'arbre est très profond), texte (mots tirés selon une loi de Zipf),
+//aleatoire (octets aléatoires, incompressibles), plages (octets aléatoires répétés de 1 à 256 fois)
+void generer(jeu *j, const char *nom, size_t taille)
+{
+	snprintf(j->nom, sizeof(j->nom), "%s", nom);
+	j->taille = taille;
+	j->donnees = malloc(taille);
+	if (j->donnees == NULL)
+	{
+		assert(0);
+	}
+
+	uint64_t etat = 0x9E3779B97F4A7C15ull;
+	if (strcmp(nom, "uniforme") == 0)
+	{
+		for (size_t i = 0; i < taille; i++)
+		{
+			j->donnees[i] = 'a' + aleatoire(&etat) % 16;
+		}
+	}
+	else if (strcmp(nom, "constant") == 0)
+	{
+		memset(j->donnees, 'a', taille);
+	}
+	else if (strcmp(nom, "plages") == 0)
+	{
+		size_t i = 0;
+		while (i < taille)
+		{
+			uint64_t r = aleatoire(&etat);
+			size_t n = 1 + (r & 0xff);
+			n = n < taille - i ? n : taille - i;
+			memset(j->donnees + i, (int)(r >> 56), n);
+			i += n;
+		}
+	}
+	else if (strcmp(nom, "aleatoire") == 0)
+	{
+		for (size_t i = 0; i < taille; i++)
+		{
+			j->donnees[i] = (uint8_t)(aleatoire(&etat) >> 56);
+		}
+	}
+	else if (strcmp(nom, "zipf") == 0 || strcmp(nom, "fibonacci") == 0)
+	{
+		double cumul[256]; //fonction de répartition, on tire un caractère par recherche dichotomique
+		double total = 0, f1 = 1, f2 = 1;
+		for (int k = 0; k < 256; k++)
+		{
+			double poids;
+			if (nom[0] == 'z')
+			{
+				poids = 1.0 / (k + 1);
+			}
+			else
+			{
+				poids = k < 40 ? f1 : 0; //au delà de 40 termes les plus rares n'apparaissent plus
+				double f = f1 + f2;
+				f1 = f2;
+				f2 = f;
+			}
+			total += poids;
+			cumul[k] = total;
+		}
+		for (size_t i = 0; i < taille; i++)
+		{
+			double u = (aleatoire(&etat) >> 11) * (1.0 / 9007199254740992.0) * total;
+			int bas = 0, haut = 255;
+			while (bas < haut)
+			{
+				int milieu = (bas + haut) / 2;
+				if (cumul[milieu] <= u)
+				{
+					bas = milieu + 1;
+				}
+				else
+				{
+					haut = milieu;
+				}
+			}
+			j->donnees[i] = (uint8_t)(nom[0] == 'z' ? bas : 255 - bas);
+		}
+	}
+	else //texte
+	{
+		static const char *mots[] = {"le", "de", "un", "et", "la", "les", "des", "en", "du", "une", "est", "que", "pour", "dans",
+			"qui", "par", "sur", "avec", "au", "pas", "plus", "compression", "fichier", "arbre", "code", "caractère", "bloc",
+			"données", "table", "longueur", "décodage", "Huffman", "fréquence", "nœud", "bits", "octets", "sortie", "entrée"};
+		int nb_mots = sizeof(mots) / sizeof(mots[0]);
+		size_t i = 0;
+		while (i < taille)
+		{
+			uint64_t r = aleatoire(&etat);
+			int k = (int)((r % 1000) * (r % 1000) / 1000 * nb_mots / 1000); //les premiers mots sont les plus fréquents
+			const char *m = mots[k];
+			for (size_t c = 0; m[c] != '\0' && i < taille; c++)
+			{
+				j->donnees[i++] = (uint8_t)m[c];
+			}
+			if (i < taille)
+			{
+				j->donnees[i++] = (r >> 32) % 13 == 0 ? ((r >> 40) % 3 == 0 ? '\n' : '.') : ' ';
+			}
+		}
+	}
+}
+
+//fonction pour lire un fichier entier en mémoire
+void charger_fichier(jeu *j, const char *fichier)
+{
+	FILE *f = fopen(fichier, "rb");
+	if (f == NULL || fseek(f, 0, SEEK_END) != 0)
+	{
+		fprintf(stderr, "Erreur : impossible d'ouvrir le fichier %s\n", fichier);
+		exit(EXIT_FAILURE);
+	}
+	long taille = ftell(f);
+	rewind(f);
+	snprintf(j->nom, sizeof(j->nom), "%s", fichier);
+	j->taille = taille;
+	j->donnees = malloc(taille > 0 ? taille : 1);
+	if (j->donnees == NULL)
+	{
+		assert(0);
+	}
+	if (fread(j->donnees, 1, j->taille, f) != j->taille)
+	{
+		fprintf(stderr, "Erreur : impossible de lire le fichier %s\n", fichier);
+		exit(EXIT_FAILURE);
+	}
+	fclose(f);
+}
+
+//fonction qui renvoie le nombre d'octets des données compressées qui ne sont pas des données codées : en-tête du fichier,
+//en-tête de chaque bloc, en-têtes des longueurs et des groupes de contextes, identifiants de dictionnaire, tables de saut, marqueur de fin, index et pied
+//(seulement le magic et l'en-tête du bloc pour un message court)
+size_t taille_en_tetes(const uint8_t *src, size_t taille)
+{
+	bloc_index *blocs;
+	uint32_t nb_blocs;
+	uint64_t taille_sortie;
+	if (lire_index(src, taille, &blocs, &nb_blocs, &taille_sortie) != HUFF_OK)
+	{
+		return 0;
+	}
+	size_t t = lire_u32(src) == MAGIC_MESSAGE ? TAILLE_EN_TETE_MESSAGE : TAILLE_EN_TETE_FICHIER + 1 + (size_t)nb_blocs * TAILLE_ENTREE_INDEX + TAILLE_PIED;
+	for (uint32_t i = 0; i < nb_blocs; i++)
+	{
+		const uint8_t *bloc = src + blocs[i].position;
+		uint8_t longueurs[256];
+		t += TAILLE_EN_TETE_BLOC;
+		if (TYPE_BLOC(bloc[0]) == BLOC_TABLE)
+		{
+			t += lire_longueurs(bloc + TAILLE_EN_TETE_BLOC, blocs[i].taille - TAILLE_EN_TETE_BLOC, longueurs);
+		}
+		else if (TYPE_BLOC(bloc[0]) == BLOC_DICTIONNAIRE)
+		{
+			t += 4;
+		}
+		else if (TYPE_BLOC(bloc[0]) == BLOC_CONTEXTE)
+		{
+			tables_contexte mc;
+			size_t lus;
+			if (charger_contexte(bloc + TAILLE_EN_TETE_BLOC, blocs[i].taille - TAILLE_EN_TETE_BLOC, &mc, &lus) == HUFF_OK)
+			{
+				t += lus;
+				free_tables_contexte(&mc);
+			}
+		}
+		else if (TYPE_BLOC(bloc[0]) == BLOC_PLAGES)
+		{
+			size_t lus;
+			table_decodage *table;
+			if (charger_plages(bloc + TAILLE_EN_TETE_BLOC, blocs[i].taille - TAILLE_EN_TETE_BLOC, &table, &lus) == HUFF_OK)
+			{
+				t += lus;
+				free_table(table);
+			}
+		}
+		if (bloc[0] & BLOC_4_FLUX)
+		{
+			t += TAILLE_TABLE_SAUT;
+		}
+	}
+	free(blocs);
+	return t;
+}
+
+//fonction pour chronométrer chaque phase sur tous les blocs de l'entrée, sans choix du codage ni threads :
+//comptage, arbre et longueurs, codes canoniques, codage, table de décodage et décodage. m->phases reçoit la durée de chaque phase.
+void mesurer_phases(const jeu *j, const huff_options *o, mesures *m)
+{
+	uint8_t *codees = malloc(FLUX_SURCOUT + o->taille_bloc * LONGUEUR_MAX / 8 + 8); //8 octets de marge pour encoder
+	uint8_t *decodees = malloc(o->taille_bloc);
+	if (codees == NULL || decodees == NULL)
+	{
+		assert(0);
+	}
+	memset(m->phases, 0, sizeof(m->phases));
+
+	for (size_t debut = 0; debut < j->taille; debut += o->taille_bloc)
+	{
+		size_t taille = j->taille - debut < o->taille_bloc ? j->taille - debut : o->taille_bloc;
+		const uint8_t *donnees = j->donnees + debut;
+		uint64_t tab[256];
+		uint8_t longueurs[256];
+		code_huffman codes[256] = {0};
+		int nb_flux = nb_flux_bloc(o, taille);
+
+		double t0 = maintenant();
+		apparitions(donnees, taille, tab);
+		double t1 = maintenant();
+		longueurs_bloc(tab, 256, o->lg_max, longueurs); //lg_max >= 8 : tous les caractères ont un code
+		double t2 = maintenant();
+		codes_huffman(longueurs, 256, codes);
+		double t3 = maintenant();
+		size_t taille_codee = encoder_flux(donnees, taille, codes, NULL, nb_flux, codees);
+		double t4 = maintenant();
+		table_decodage *table = creer_table(longueurs, 256);
+		double t5 = maintenant();
+		if (table == NULL)
+		{
+			assert(0);
+		}
+		int r = nb_flux == 4 ? decoder_4_flux(table, NULL, codees, taille_codee, decodees, taille, taille)
+			: decoder_donnees(table, codees, taille_codee, decodees, taille);
+		double t6 = maintenant();
+		free_table(table);
+
+		if (r != 0 || memcmp(decodees, donnees, taille) != 0)
+		{
+			fprintf(stderr, "Erreur : le bloc à la position %zu de %s n'est pas décodé à l'identique.\n", debut, j->nom);
+			exit(EXIT_FAILURE);
+		}
+		m->phases[PHASE_HISTOGRAMME] += t1 - t0;
+		m->phases[PHASE_ARBRE] += t2 - t1;
+		m->phases[PHASE_CODES] += t3 - t2;
+		m->phases[PHASE_CODAGE] += t4 - t3;
+		m->phases[PHASE_TABLES] += t5 - t4;
+		m->phases[PHASE_DECODAGE] += t6 - t5;
+	}
+	free(codees);
+	free(decodees);
+}
+
+//fonction pour mesurer un jeu de données : compression et décompression complètes par la bibliothèque, puis chaque phase.
+//Chaque durée est la meilleure des essais, les tampons sont alloués une seule fois.
+void mesurer(const jeu *j, const huff_options *o, int essais, mesures *m)
+{
+	size_t capacite = huff_taille_max(j->taille, o);
+	uint8_t *compressees = malloc(capacite);
+	uint8_t *decompressees = malloc(j->taille > 0 ? j->taille : 1);
+	if (compressees == NULL || decompressees == NULL)
+	{
+		assert(0);
+	}
+
+	mesures essai;
+	for (int e = 0; e < essais; e++)
+	{
+		double t0 = maintenant();
+		size_t taille_compressee = capacite;
+		int r = huff_compresser(j->donnees, j->taille, compressees, &taille_compressee, o);
+		double t1 = maintenant();
+		size_t taille_decompressee = j->taille;
+		if (r == HUFF_OK)
+		{
+			r = huff_decompresser(compressees, taille_compressee, decompressees, &taille_decompressee, o);
+		}
+		double t2 = maintenant();
+		if (r != HUFF_OK || taille_decompressee != j->taille || memcmp(decompressees, j->donnees, j->taille) != 0)
+		{
+			fprintf(stderr, "Erreur : %s n'est pas décompressé à l'identique (%s).\n", j->nom, huff_erreur(r));
+			exit(EXIT_FAILURE);
+		}
+		mesurer_phases(j, o, &essai);
+
+		if (e == 0 || t1 - t0 < m->compression)
+		{
+			m->compression = t1 - t0;
+		}
+		if (e == 0 || t2 - t1 < m->decompression)
+		{
+			m->decompression = t2 - t1;
+		}
+		for (int p = 0; p < NB_PHASES; p++)
+		{
+			if (e == 0 || essai.phases[p] < m->phases[p])
+			{
+				m->phases[p] = essai.phases[p];
+			}
+		}
+		m->taille_compressee = taille_compressee;
+	}
+	m->en_tetes = taille_en_tetes(compressees, m->taille_compressee);
+
+	struct rusage u;
+	getrusage(RUSAGE_SELF, &u);
+	m->rss_max = u.ru_maxrss; //pic du processus depuis son lancement
+	free(compressees);
+	free(decompressees);
+}
+
+//fonction pour afficher les mesures d'un jeu : une ligne de tableau, ou un objet JSON
+void afficher(const jeu *j, const mesures *m, int json, int premier)
+{
+	double mo = j->taille / 1e6;
+	double ratio = m->taille_compressee > 0 ? (double)j->taille / m->taille_compressee : 0;
+	double octets = j->taille > 0 ? (double)j->taille : 1;
+	if (json)
+	{
+		printf("%s  {\"nom\": \"", premier ? "" : ",\n");
+		for (const char *c = j->nom; *c != '\0'; c++) //le nom d'un fichier peut contenir des caractères à échapper
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				putchar('\\');
+			}
+			putchar((unsigned char)*c < 0x20 ? '?' : *c);
+		}
+		printf("\", \"taille\": %zu, \"taille_compressee\": %zu, \"ratio\": %.4f, \"en_tetes\": %zu, ", j->taille, m->taille_compressee, ratio, m->en_tetes);
+		printf("\"compression_mo_s\": %.1f, \"compression_ns_octet\": %.3f, ", mo / m->compression, m->compression * 1e9 / octets);
+		printf("\"decompression_mo_s\": %.1f, \"decompression_ns_octet\": %.3f, ", mo / m->decompression, m->decompression * 1e9 / octets);
+		printf("\"phases_ns_octet\": {");
+		for (int p = 0; p < NB_PHASES; p++)
+		{
+			printf("%s\"%s\": %.3f", p > 0 ? ", " : "", noms_phases[p], m->phases[p] * 1e9 / octets);
+		}
+		printf("}, \"rss_max_ko\": %ld}", m->rss_max);
+	}
+	else
+	{
+		printf("%-24s %12zu %8.3f %10zu %10.1f %10.1f %8ld  ", j->nom, j->taille, ratio, m->en_tetes, mo / m->compression, mo / m->decompression, m->rss_max);
+		for (int p = 0; p < NB_PHASES; p++)
+		{
+			printf(" %.3f", m->phases[p] * 1e9 / octets);
+		}
+		printf("\n");
+	}
+	fflush(stdout);
+}
+
+//fonction pour chronométrer le comptage des caractères de toute l'entrée, par zones de HISTO_BLOC comme dans apparitions,
+//avec le noyau scalaire puis avec le noyau choisi pour ce processeur. debits reçoit leurs débits en Mo/s, meilleur des essais.
+void mesurer_histogramme(const jeu *j, int essais, double debits[2])
+{
+	noyau_histogramme noyaux[2] = {histogramme_bloc, choisir_histogramme()};
+	static uint32_t sous[HISTO_SOUS_TABLES][256];
+	double meilleure[2] = {0, 0};
+	for (int e = 0; e < essais; e++) //les essais des deux noyaux alternent : ils subissent les mêmes variations de la machine
+	{
+		for (int k = 0; k < 2; k++)
+		{
+			memset(sous, 0, sizeof(sous));
+			double t0 = maintenant();
+			for (size_t debut = 0; debut < j->taille; debut += HISTO_BLOC)
+			{
+				size_t n = j->taille - debut < HISTO_BLOC ? j->taille - debut : HISTO_BLOC;
+				noyaux[k](j->donnees + debut, n, sous);
+			}
+			double t1 = maintenant();
+			if (e == 0 || t1 - t0 < meilleure[k])
+			{
+				meilleure[k] = t1 - t0;
+			}
+			
+			uint64_t total = 0; //le total est vérifié, le comptage ne peut donc pas être retiré par le compilateur
+			for (int t = 0; t < HISTO_SOUS_TABLES; t++)
+			{
+				for (int c = 0; c < 256; c++)
+				{
+					total += sous[t][c];
+				}
+			}
+			if (total != j->taille)
+			{
+				fprintf(stderr, "Erreur : le noyau %d ne compte pas tous les caractères de %s.\n", k, j->nom);
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+	for (int k = 0; k < 2; k++)
+	{
+		debits[k] = meilleure[k] > 0 ? j->taille / meilleure[k] / 1e6 : 0;
+	}
+}
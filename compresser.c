@@ -1,532 +1,671 @@
 /*Projet Huffman - Compression et Décompression de fichiers en C
 Auteur : Rosselle QUIZON
-Description du code : Implémente la compression de fichiers en utilisant l'algorithme de Huffman*/
+Description du code : Implémente la compression de fichiers en utilisant l'algorithme de Huffman (bibliothèque huffman.c)*/
  
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <assert.h>
-#include <math.h>
 #include <string.h>
-
-//structure représentant un noeud de l'arbre de Huffman
-typedef struct _noeud
-{
-	uint32_t lettre; //Code ASCII du caractère
-	uint32_t poids; //Nombre d'apparitions du caractère
-	struct _noeud *parent;
-	struct _noeud *gauche;
-	struct _noeud *droite;
-	struct _noeud *suivant; 
-} noeud;				
-
-//structure qui va représenter une liste triée des fréquences des caractères
-typedef struct
-{
-	uint64_t taille; 
-	noeud *tete; 
-	noeud *queue;
-} liste; 
-
-//structure pour stocker les codes Huffman
-typedef struct _maillon
-{
-    noeud *n;
-    char code[32];
-    struct _maillon *suivant;
-} maillon;				
-
-
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <dirent.h>
+
+#include "huffman.h"
+#include "outils.h"
+
+//structure représentant le fichier d'entrée : projeté en mémoire si c'est un fichier régulier, lu par morceaux sinon
 typedef struct {
-    maillon *tete;
-    maillon *queue;
-    uint32_t taille;
-} File;					
+	const uint8_t *donnees; //NULL si l'entrée est un tube
+	size_t taille;
+	void *projection; //zone renvoyée par mmap
+	int fd;
+} entree;
 
-uint32_t* apparitions(FILE *f);
-noeud* creer_noeud(uint32_t d, uint32_t i);
-uint32_t min(uint32_t *tab);
-liste* liste_croissante(uint32_t *tab);
-void add_a_la_position(liste *l, noeud *m);
-noeud* rem_tete(liste *l);
-noeud* creer_arbre(liste *l);
-void verifier_arbre(noeud *racine);
-void free_arbre(noeud *racine);
-void free_liste(liste *l);
-void codes_huffman(noeud *racine, char codes[256][32]);
-noeud* defiler(File *f, char *code);
-void enfiler(File *f, noeud *n, char *code);
-uint32_t en_tete(FILE *out, char codes[256][32]);
-void compresser(char *fichier, char *sortie, char codes[256][32]);
+//structure d'un lot de fichiers à compresser en une archive : leurs contenus sont lus à la suite dans un seul tampon
+typedef struct {
+	huff_membre *membres;
+	size_t nb_membres;
+	size_t capacite;
+	size_t *debuts; //position du contenu de chaque membre dans donnees, qui peut être déplacé pendant la lecture
+	uint8_t *donnees;
+	size_t taille;
+	size_t capacite_donnees;
+} lot;
+
+entree* charger_entree(const char *fichier);
+void free_entree(entree *e);
+int ecrire_fichier(void *ctx, const void *p, size_t n);
+void entrainer(const char *fichier, char **echantillons, int nb_echantillons, int lg_max);
+void compresser(entree *e, const char *sortie, const huff_options *o);
+int compresser_blocs(entree *e, FILE *out, const huff_options *o);
+int compresser_petit(const entree *e, FILE *out, const huff_options *o);
+void ajouter_fichier(lot *l, const char *chemin, const char *nom);
+int comparer_noms(const void *a, const void *b);
+void parcourir_repertoire(lot *l, const char *repertoire, const char *prefixe);
+void lire_liste(lot *l, const char *fichier);
+void compresser_lot(const char *source, const char *sortie, const huff_options *o);
 
 int main(int argc, char *argv[])
 {
-    	if (argc < 3) 				
+    	struct timespec debut;
+    	clock_gettime(CLOCK_MONOTONIC, &debut);
+    	huff_options o;
+    	huff_options_defaut(&o);
+    	huff_stats stats = {0};
+    	long nb_threads = sysconf(_SC_NPROCESSORS_ONLN); //un thread de compression par coeur par défaut
+    	int entrainement = 0; //avec --entrainer on construit un dictionnaire à partir d'échantillons
+    	int par_lot = 0; //avec --batch on compresse une liste de fichiers ou un répertoire en une archive
+    	const char *dictionnaire = NULL;
+    	int a = 1;
+    	while (a < argc && strncmp(argv[a], "--", 2) == 0)
     	{
-        	fprintf(stderr, "Usage: %s fichier_entree fichier_sortie\n", argv[0]);	
+    		if (strcmp(argv[a], "--max-code-len") == 0 && a + 1 < argc)
+    		{
+    			o.lg_max = atoi(argv[a + 1]);
+    			if (o.lg_max < 1 || o.lg_max > HUFF_LONGUEUR_MAX)
+    			{
+        			fprintf(stderr, "Erreur : --max-code-len doit être compris entre 1 et %d.\n", HUFF_LONGUEUR_MAX);
+        			return EXIT_FAILURE;
+    			}
+    			a += 2;
+    		}
+    		else if (strcmp(argv[a], "--block-size") == 0 && a + 1 < argc)
+    		{
+    			//un nombre sans signe, suivi au plus d'un des suffixes K, M et G pour les kibioctets, les mébioctets et les gibioctets
+    			const char *valeur = argv[a + 1];
+    			char *fin;
+    			errno = 0;
+    			unsigned long long n = strtoull(valeur, &fin, 10);
+    			int decalage = 0;
+    			if (*fin == 'K' || *fin == 'k')
+    			{
+    				decalage = 10;
+    				fin++;
+    			}
+    			else if (*fin == 'M' || *fin == 'm')
+    			{
+    				decalage = 20;
+    				fin++;
+    			}
+    			else if (*fin == 'G' || *fin == 'g')
+    			{
+    				decalage = 30;
+    				fin++;
+    			}
+    			//strtoull accepte un signe moins et des espaces au début ; la borne est comparée avant le décalage, qui ne peut donc pas déborder
+    			if (valeur[0] < '0' || valeur[0] > '9' || *fin != '\0' || errno == ERANGE || n == 0 || n > (HUFF_TAILLE_BLOC_MAX >> decalage))
+    			{
+        			fprintf(stderr, "Erreur : --block-size doit être un nombre entre 1 et %zu octets, suivi au plus de K, M ou G.\n", HUFF_TAILLE_BLOC_MAX);
+        			return EXIT_FAILURE;
+    			}
+    			o.taille_bloc = (size_t)n << decalage;
+    			a += 2;
+    		}
+    		else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc)
+    		{
+    			nb_threads = atol(argv[a + 1]);
+    			a += 2;
+    		}
+    		else if (strcmp(argv[a], "--streams") == 0 && a + 1 < argc) //nombre de flux entrelacés dans chaque bloc
+    		{
+    			o.nb_flux = atoi(argv[a + 1]);
+    			if (o.nb_flux != 1 && o.nb_flux != 4)
+    			{
+        			fprintf(stderr, "Erreur : --streams doit valoir 1 ou 4.\n");
+        			return EXIT_FAILURE;
+    			}
+    			a += 2;
+    		}
+    		else if (strcmp(argv[a], "--order") == 0 && a + 1 < argc) //1 : une table par groupe de contextes (caractère précédent)
+    		{
+    			o.ordre = atoi(argv[a + 1]);
+    			if (o.ordre != 0 && o.ordre != 1)
+    			{
+        			fprintf(stderr, "Erreur : --order doit valoir 0 ou 1.\n");
+        			return EXIT_FAILURE;
+    			}
+    			a += 2;
+    		}
+    		else if (strcmp(argv[a], "--rle") == 0) //plages de caractères répétés codées par leur longueur
+    		{
+    			o.plages = 1;
+    			a++;
+    		}
+    		else if (strcmp(argv[a], "--stats") == 0) //mesures écrites en JSON sur la sortie d'erreur à la fin
+    		{
+    			o.stats = &stats;
+    			a++;
+    		}
+    		else if (strcmp(argv[a], "--batch") == 0)
+    		{
+    			par_lot = 1;
+    			a++;
+    		}
+    		else if (strcmp(argv[a], "--shared-table") == 0) //table commune aux membres d'une archive
+    		{
+    			o.table_commune = 1;
+    			a++;
+    		}
+    		else if (strcmp(argv[a], "--entrainer") == 0)
+    		{
+    			entrainement = 1;
+    			a++;
+    		}
+    		else if (strcmp(argv[a], "--dict") == 0 && a + 1 < argc)
+    		{
+    			dictionnaire = argv[a + 1];
+    			a += 2;
+    		}
+    		else
+    		{
+        		fprintf(stderr, "Erreur : option inconnue %s\n", argv[a]);
+        		return EXIT_FAILURE;
+    		}
+    	}
+    	o.nb_threads = nb_threads < 1 ? 1 : (int)nb_threads;
+    	
+    	if (argc - a < 2) 				
+    	{
+        	fprintf(stderr, "Usage: %s [--max-code-len N] [--block-size N[K|M|G]] [--threads N] [--streams 1|4] [--order 0|1] [--rle] [--dict dictionnaire] [--stats] fichier_entree|- fichier_sortie|-\n", argv[0]);	
+        	fprintf(stderr, "       %s --batch [--shared-table] [options] liste|repertoire archive|-\n", argv[0]);	
+        	fprintf(stderr, "       %s --entrainer [--max-code-len N] dictionnaire echantillon...\n", argv[0]);	
         	return EXIT_FAILURE; //si il n'y a pas le fichier à compresser et le fichier de sortie dans l'execution
     	}
     	
-    	FILE *f = fopen(argv[1], "rb");
-    	if (f == NULL) 
+    	if (entrainement)
     	{
-        	fprintf(stderr, "Erreur : impossible d'ouvrir le fichier %s\n", argv[1]);
-        	return EXIT_FAILURE;
+    		entrainer(argv[a], argv + a + 1, argc - a - 1, o.lg_max);
+    		return EXIT_SUCCESS;
     	}
-    
-    	uint32_t *tab = apparitions(f); //tableau avec le nombre d'apparitions d'un caractère
-    	fclose(f);
-    
-    	if (tab == NULL) 
+    	if (dictionnaire != NULL)
+    	{
+    		o.dictionnaire = charger_dictionnaire(dictionnaire);
+    	}
+    	if (par_lot)
     	{
-        	fprintf(stderr, "Erreur lors du comptage des fréquences.\n");
+    		compresser_lot(argv[a], argv[a + 1], &o);
+    		huff_dictionnaire_liberer((huff_dictionnaire *)o.dictionnaire);
+    		if (o.stats != NULL)
+    		{
+    			afficher_stats("compresser", o.stats, &debut);
+    		}
+    		return EXIT_SUCCESS;
+    	}
+    	
+    	entree *e = charger_entree(argv[a]); //le fichier est lu une seule fois, les deux passes de chaque bloc se font en mémoire
+    	if (e == NULL) 
+    	{
+        	fprintf(stderr, "Erreur : impossible d'ouvrir le fichier %s\n", argv[a]);
         	return EXIT_FAILURE;
     	}
     
+    	compresser(e, argv[a + 1], &o);
     
-    	liste *l = liste_croissante(tab); //liste où sont rangés les noeuds par ordre croissant de leur poids 
-    
-    	noeud *racine = creer_arbre(l); //Création de l'arbre de Huffman
-    
-    	char codes[256][32] = {0}; //tableau où on va stocker tous nos codes créés avec huffman
-    	codes_huffman(racine, codes);
-    
-    	compresser(argv[1], argv[2], codes);
-    
-    	free_arbre(racine);
-    	free_liste(l);
-    	free(tab);
+    	free_entree(e);
+    	huff_dictionnaire_liberer((huff_dictionnaire *)o.dictionnaire);
+    	if (o.stats != NULL)
+    	{
+    		afficher_stats("compresser", o.stats, &debut);
+    	}
     
     	return EXIT_SUCCESS;
 }
 
-//fonction pour compter le nombre d'apparitions de chaque caractère dans un fichier 
-uint32_t* apparitions(FILE *f)
+//fonction pour ouvrir le fichier d'entrée ("-" pour l'entrée standard)
+//un fichier régulier est projeté avec mmap, un tube sera lu bloc par bloc pendant la compression
+entree* charger_entree(const char *fichier)
 {
-	uint32_t *tab = malloc(256 * sizeof(uint32_t)); 
-	
-	if (tab == NULL)
+	int fd = strcmp(fichier, "-") == 0 ? STDIN_FILENO : open(fichier, O_RDONLY);
+	if (fd < 0)
 	{
-		fprintf(stderr, "Erreur dans la création du tableau de nombre d'apparitions\n");
 		return NULL;
 	}
 	
-	for (int i = 0; i < 256; i++) 
+	entree *e = malloc(sizeof(entree));
+	if (e == NULL)
 	{
-		tab[i] = 0; //on initialise tout le tableau à 0
+		assert(0);
 	}
+	e->donnees = NULL;
+	e->taille = 0;
+	e->projection = NULL;
+	e->fd = fd;
 	
-	int e;
-	while ((e=fgetc(f)) != EOF) //on parcourt le fichier caractère par caractère
- 	{
-		tab[e] += 1; //la frequence à l'indice i correspond au caractère dont le nombre ascii associé est i
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		return e; //entrée non projetable (tube, terminal)
 	}
 	
-	return tab;
+	e->taille = st.st_size;
+	e->donnees = (const uint8_t *)""; //une entrée vide n'a aucun bloc
+	if (e->taille > 0) //mmap refuse une projection de taille nulle
+	{
+		e->projection = mmap(NULL, e->taille, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (e->projection == MAP_FAILED)
+		{
+			free(e);
+			return NULL;
+		}
+		madvise(e->projection, e->taille, MADV_SEQUENTIAL);
+		e->donnees = e->projection;
+	}
+	return e;
 }
 
-//fonction pour créer un noeud de l'arbre de Huffman
-noeud* creer_noeud(uint32_t d, uint32_t i)
+//fonction pour libérer le fichier d'entrée
+void free_entree(entree *e)
 {
-	noeud *m = malloc(sizeof(noeud)); 
-	if(m==NULL)
+	if (e->projection != NULL)
 	{
-		assert(0);
+		munmap(e->projection, e->taille);
 	}
-	m->poids = d;
-	m->lettre = i;
-	m->parent = NULL;
-	m->gauche = NULL;
-	m->droite = NULL;
-	m->suivant = NULL;
-	
-	return m;
-}	
-
-//fonction pour trouver l'indice du caractère avec la fréquence minimale 
-uint32_t min(uint32_t *tab) 
-{
-	uint32_t i_min = 0; 
-	while (tab[i_min] == 0) 
+	if (e->fd != STDIN_FILENO)
 	{
-        	i_min++; 
-        }
-	
-	uint32_t min = tab[i_min];
-	    
-	//on a choisi le premier indice i_min dont la valeur au tableau n'est pas égal à 0
-	//pour pouvoir initialiser le minimum avec cette valeur avant de trouver le vrai minimum à l'aide du for suivant
-	for (uint32_t i = 0; i < 256; i++) 
-	{
-		if (tab[i] > 0 && tab[i] < min) 
-		{ 
-			min = tab[i];
-			i_min = i;
-		}
+		close(e->fd);
 	}
-	
-	return i_min; 
+	free(e);
 }
 
-//fonction pour construire une liste croissante des fréquences des caractères
-liste* liste_croissante(uint32_t *tab) 
+//fonction d'écriture passée au compresseur : les blocs compressés sont écrits dans le fichier de sortie
+int ecrire_fichier(void *ctx, const void *p, size_t n)
 {
-	liste *r = malloc(sizeof(liste)); //on initialise une liste 
-	if(r==NULL)
+	return fwrite(p, 1, n, ctx) == n ? 0 : -1;
+}
+
+//fonction pour entraîner un dictionnaire sur des échantillons et l'écrire dans un fichier :
+//les apparitions des caractères sont comptées sur tous les échantillons, puis la table des longueurs est calculée une fois
+void entrainer(const char *fichier, char **echantillons, int nb_echantillons, int lg_max)
+{
+	huff_dictionnaire *d = huff_dictionnaire_creer();
+	if (d == NULL)
 	{
 		assert(0);
 	}
-	r->taille = 0;
-	r->tete = NULL;
-	r->queue = NULL;
-	
-	uint32_t nb = 0; //cet entier va compter le nombre de caractères présents dans le fichier 
-	//(car il n'y a pas forcément les 256 caractères de la table ascii)
-	for (uint32_t i = 0; i < 256; i++)
+	for (int k = 0; k < nb_echantillons; k++)
 	{
-		if (tab[i] > 0)
+		entree *e = charger_entree(echantillons[k]);
+		if (e == NULL)
 		{
-			nb++;
+        		fprintf(stderr, "Erreur : impossible d'ouvrir le fichier %s\n", echantillons[k]);
+        		exit(EXIT_FAILURE);
 		}
-	}
-	
-	uint32_t j = 0; 
-	while (j < nb)
-	{
-	    	uint32_t k = min(tab); 
-		uint32_t poids = tab[k]; 
-		noeud *t = creer_noeud(poids, k); 
-		add_a_la_position(r, t); 
-		tab[k] = 0; //on remet à 0 la valeur du tableau afin de ne pas reprendre le même caractère
-		j++;
-	}
-	return r;
-}
-	
-//fonction qui ajoute un noeud à sa position correcte dans la liste triée
-void add_a_la_position(liste *l, noeud *m)
-{
-	if (l->tete == NULL|| m->poids < l->tete->poids) 
-	{
-	       
-		m->suivant = l->tete;
-		l->tete = m;
-		if (l->taille == 0) 
+		if (e->donnees != NULL)
 		{
-			l->queue = m;
+			huff_dictionnaire_ajouter(d, e->donnees, e->taille);
 		}
-	} 
-	else
-	{
-		noeud *n = l->tete;
-		while (n->suivant !=NULL && n->suivant->poids <= m->poids) 
+		else
 		{
-			n = n->suivant;
+			uint8_t tampon[1 << 16];
+			ssize_t lus;
+			while ((lus = read(e->fd, tampon, sizeof(tampon))) > 0)
+			{
+				huff_dictionnaire_ajouter(d, tampon, lus);
+			}
 		}
-		m->suivant = n->suivant;
-		n->suivant = m;
+		free_entree(e);
 	}
-	l->taille++;
-}
-
-
-//fonction qui supprime et retourne le premier noeud de la liste
-noeud* rem_tete(liste *l)
-{
-	if (l->tete == NULL) 
+	
+	int r = huff_dictionnaire_entrainer(d, lg_max);
+	if (r == HUFF_ERREUR_PARAMETRE)
 	{
-		return NULL;
+		fprintf(stderr, "Erreur : un dictionnaire demande --max-code-len entre 8 et %d.\n", HUFF_LONGUEUR_MAX);
+		exit(EXIT_FAILURE);
 	}
-	
-	noeud *t = l->tete;
-	l->tete = l->tete->suivant;
-	l->taille -= 1;
-	if( l->taille == 0 )
+	if (r != HUFF_OK)
 	{
-		l->queue = NULL;
+		fprintf(stderr, "Erreur : %s.\n", huff_erreur(r));
+		exit(EXIT_FAILURE);
 	}
-	return t;
-}
-
-//fonction qui construit l'arbre de Huffman à partir de la liste triée 
-noeud* creer_arbre(liste *l)
-{
-	while (l->taille > 1)
-	{
-		noeud *min1 = rem_tete(l);
-		noeud *min2 = rem_tete(l);
-		
-		//on choisit comme valeur arbitraire 500 (pas dans la table ascii) pour indiquer qu'il ne s'agit pas d'une feuille
-		noeud *fusion = creer_noeud(min1->poids + min2->poids, 500); 
-		
-		min1->parent = fusion;
-		min2->parent = fusion;
-		fusion->gauche = min1;
-		fusion->droite = min2;
-		
-		add_a_la_position(l, fusion);	
 	
-	}
-
-	return l->tete; //lorsque toutes les fusions sont faites, il ne nous reste plus que la racine
-}
-
-//fonction pour liberer la mémoire de la liste
-void free_liste(liste *l)
-{
-	free(l);
-}
-
-//fonction pour liberer la mémoire de l'arbre
-void free_arbre(noeud *racine)
-{
-	if (racine == NULL)
+	uint8_t tampon[HUFF_TAILLE_DICTIONNAIRE_MAX];
+	size_t taille = huff_dictionnaire_ecrire(d, tampon);
+	FILE *f = fopen(fichier, "wb");
+	if (f == NULL || fwrite(tampon, 1, taille, f) != taille || fclose(f) != 0)
 	{
-        	return;
-        }
-
-	free_arbre(racine->gauche);
-	free_arbre(racine->droite);
-
-	free(racine);
+		fprintf(stderr, "Erreur d'écriture du dictionnaire %s.\n", fichier);
+		exit(EXIT_FAILURE);
+	}
+	printf("Dictionnaire %s : identifiant %08x\n", fichier, huff_dictionnaire_id(d));
+	huff_dictionnaire_liberer(d);
 }
 
-//fonction pour ajouter un noeud dans la file
-void enfiler(File *f, noeud *n, char *code)
-{
-    	maillon *m = malloc(sizeof(maillon)); //on initialise un maillon
-    	if (m == NULL)
-    	{	
-    		assert(0);
+//fonction principale de compression : l'entrée est passée au compresseur de la bibliothèque, qui compresse
+//les blocs en parallèle et les écrit dans l'ordre, suivis du marqueur de fin et de l'index des blocs.
+//Un petit fichier qui tient dans un bloc est compressé en une fois, sans threads (compresser_petit).
+//La sortie est écrite séquentiellement : elle peut être un tube ("-" pour la sortie standard).
+void compresser(entree *e, const char *sortie, const huff_options *o)
+{   	
+    	FILE *out = strcmp(sortie, "-") == 0 ? stdout : fopen(sortie, "wb"); //on va écrire dans le fichier de sortie en mode binaire 
+    	if (out == NULL)
+    	{
+		fprintf(stderr, "Erreur : impossible d'ouvrir le fichier %s pour écriture.\n", sortie);
+		exit(EXIT_FAILURE);
     	}
-
-    	m->n = n;
-    	strcpy(m->code, code);
-    	m->suivant = NULL;
-
-    	if (f->taille > 0)
+    	
+    	int r;
+    	if (e->donnees != NULL && huff_petit_possible(e->taille, o)) //un tube est compressé en flux
     	{
-        	f->queue->suivant = m;
+    		r = compresser_petit(e, out, o);
     	}
     	else
     	{
-        	f->tete = m;
+    		r = compresser_blocs(e, out, o);
     	}
-
-    	f->queue = m;
-    	f->taille += 1;
-}
-
-//fonction pour retirer un noeud de la file
-noeud* defiler(File *f, char *code)
-{
-    	maillon *tmp = f->tete;
-    	noeud *n = tmp->n;  
-    	strcpy(code, tmp->code);  
-
-    	f->tete = tmp->suivant;
-    	free(tmp);
-    	f->taille -= 1;
     	
-    	if (f->taille == 0)
+    	if (r == HUFF_ERREUR_ECRITURE || fflush(out) != 0)
     	{
-    		f->queue = NULL; 
+		fprintf(stderr, "Erreur d'écriture dans le fichier de sortie.\n");
+		exit(EXIT_FAILURE);
     	}
-  
-    	return n;  
-}
-
-//fonction pour générer les codes Huffman
-void codes_huffman(noeud *racine, char codes[256][32])
-{
-    
-    	File *f = malloc(sizeof(File)); //on initialise une file
-    	if (f == NULL)
+    	if (r != HUFF_OK)
     	{
-    		assert(0);
+		fprintf(stderr, "Erreur : %s.\n", huff_erreur(r));
+		exit(EXIT_FAILURE);
     	}
-    	f->tete = NULL;
-    	f->queue = NULL;
-    	f->taille = 0;
-    	
-    	enfiler(f, racine, "");  
-
-    	while (f->taille > 0)  
+    	if (out != stdout)
     	{
-        	char code[32];
-        	noeud *n = defiler(f, code);  //on recupere le code de la tete de la file
-
-        	if (n->gauche == NULL && n->droite == NULL)  //si on est arrivé à une feuille de l'arbre
-        	{
-            		strcpy(codes[n->lettre], code); //on copie ce code dans notre tableau
-        	}
-        	else  
-        	{
-            		char gauche_code[32], droite_code[32];
-
-            		strcpy(gauche_code, code); //on passe au noeud suivant gauche
-            		strcat(gauche_code, "0");
-            		enfiler(f, n->gauche, gauche_code); //
-	
-            		strcpy(droite_code, code); //on passe au noeud suivant gauche
-            		strcat(droite_code, "1");
-            		enfiler(f, n->droite, droite_code);
-        	}
+    		fclose(out);
     	}
-    
-    	maillon *n = f->tete;
-    	while (n != NULL) //on libère la mémoire de la file
-    	{	
-        	maillon *tmp = n;
-        	n = n->suivant;
-        	free(tmp);  
-    	}	
-    	free(f); 
 }
 
-//fonction pour creer l'en tete du fichier compressé
-uint32_t en_tete(FILE *out, char codes[256][32])
+//fonction pour compresser l'entrée avec le compresseur en flux de la bibliothèque, elle renvoie son code de retour
+int compresser_blocs(entree *e, FILE *out, const huff_options *o)
 {
-    	uint32_t decalage = 0;
-
-    	uint16_t nb_codes = 0; //on va calculer le nombre de codes huffman, donc le nombre de caractères présents dans le fichier 
-    	for (uint16_t i = 0; i < 256; i++) 
+    	huff_compresseur *c = huff_compresseur_creer(o, ecrire_fichier, out);
+    	if (c == NULL) //options invalides ou allocation échouée
     	{
-        	if (codes[i][0] != '\0') 
-        	{
-            		nb_codes++;
-        	}
+		fprintf(stderr, "Erreur : %s, ou %s.\n", huff_erreur(HUFF_ERREUR_PARAMETRE), huff_erreur(HUFF_ERREUR_MEMOIRE));
+		exit(EXIT_FAILURE);
     	}
     	
-
-    	fwrite(&nb_codes, sizeof(uint16_t), 1, out); //on ecrit le nombre total de codes au debut
-    	decalage = decalage + 2;
-    
-    	for (uint16_t i = 0; i < 256; i++) //on va parcourir le tableau codes pour recuperer les codes huffman
+    	int r;
+    	if (e->donnees != NULL)
     	{
-        	if (codes[i][0] != '\0') 
-        	{
-            		uint8_t valeur = i;
-            		fwrite(&valeur, sizeof(uint8_t), 1, out); //on ecrit d'abord le code ascii du caractère
-            		decalage += 1;
-            		
-            		uint8_t code_length = (uint8_t)strlen(codes[i]); //on écrit ensuite la longueur du code huffman
-            		fwrite(&code_length, sizeof(uint8_t), 1, out); 
-            		decalage += 1;
-            		
-            		fwrite(codes[i], sizeof(char), code_length, out); //enfin, on écrit le code
-            		
-            		decalage = decalage + code_length; //on additionne code_length à decalage pour la taille totale de l'en tête
-        	}
+    		huff_compresseur_taille_totale(c, e->taille); //la taille est connue, elle est écrite dans l'en tête
+    		r = huff_compresseur_ecrire_sans_copie(c, e->donnees, e->taille); //les blocs sont compressés directement dans la projection
     	}
-
-    	uint32_t position = decalage; //on sauvegarde la position à partir de laquelle commence la partie compressée
-    	
-    	uint8_t remplissage = 0; //on ecrit un octet de remplissage
-    	fwrite(&remplissage, sizeof(uint8_t), 1, out);
-    	decalage += 1;
-
-    	return position;
-}
-
-//fonction principale de compression
-void compresser(char *fichier, char *sortie, char codes[256][32])
-{   	
-    	FILE *in = fopen(fichier, "rb"); //on lit le fichier d'entrée en mode binaire
-    	if (in == NULL)
+    	else
     	{
-    		assert(0);
+    		uint8_t *tampon = malloc(o->taille_bloc); //un tube est lu par morceaux de la taille d'un bloc
+    		if (tampon == NULL)
+    		{
+    			assert(0);
+    		}
+    		ssize_t lus;
+    		r = HUFF_OK;
+    		while (r == HUFF_OK && (lus = read(e->fd, tampon, o->taille_bloc)) != 0)
+    		{
+    			if (lus < 0)
+    			{
+				fprintf(stderr, "Erreur de lecture de l'entrée.\n");
+				exit(EXIT_FAILURE);
+    			}
+    			r = huff_compresseur_ecrire(c, tampon, lus);
+    		}
+    		free(tampon);
     	}
-    	
-    	FILE *out = fopen(sortie, "wb"); //on va écrire dans le fichier de sortie en mode binaire 
-    	if (out == NULL)
+    	if (r == HUFF_OK)
     	{
-    		if (in != NULL)
-        	{
-            		fclose(in);
-            	}
-    		assert(0);
+    		r = huff_compresseur_terminer(c);
     	}
+    	huff_compresseur_liberer(c);
+    	return r;
+}
 
-    
-    	uint32_t position = en_tete(out, codes); 
-    	//on écrit l'en tête dans le fichier de sortie et on recupère la position où commence la partie compressé
+//fonction pour compresser un petit fichier projeté en mémoire en un seul bloc avec un huff_contexte : la bibliothèque
+//ne crée ni thread ni compresseur, et le résultat est écrit en une fois
+int compresser_petit(const entree *e, FILE *out, const huff_options *o)
+{
+	static huff_contexte ctx;
+	size_t taille = huff_taille_max(e->taille, o);
+	uint8_t *tampon = malloc(taille);
+	if (tampon == NULL)
+	{
+		assert(0);
+	}
+	int r = huff_compresser_petit(&ctx, e->donnees, e->taille, tampon, &taille, o);
+	if (r == HUFF_OK && ecrire_fichier(out, tampon, taille) != 0)
+	{
+		r = HUFF_ERREUR_ECRITURE;
+	}
+	free(tampon);
+	return r;
+}
 
-    	uint8_t buffer = 0;  //buffer temporaire pour stocker les bits avant de les écrire sous forme d'octet
-    	int nb_bits = 0; //on va compter le nombre de bits actuellement stockés dans le buffer
+//fonction pour ajouter un fichier à un lot : son contenu est lu à la suite des précédents, nom est le nom du membre dans l'archive
+void ajouter_fichier(lot *l, const char *chemin, const char *nom)
+{
+	int fd = strcmp(chemin, "-") == 0 ? STDIN_FILENO : open(chemin, O_RDONLY);
+	if (fd < 0)
+	{
+        	fprintf(stderr, "Erreur : impossible d'ouvrir le fichier %s\n", chemin);
+        	exit(EXIT_FAILURE);
+	}
+	if (l->nb_membres == l->capacite)
+	{
+		l->capacite = l->capacite > 0 ? 2 * l->capacite : 64;
+		l->membres = realloc(l->membres, l->capacite * sizeof(huff_membre));
+		l->debuts = realloc(l->debuts, l->capacite * sizeof(size_t));
+		if (l->membres == NULL || l->debuts == NULL)
+		{
+			assert(0);
+		}
+	}
+	
+	size_t debut = l->taille;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && l->taille + st.st_size + 1 > l->capacite_donnees) //on prévoit la place du fichier en une fois
+	{
+		l->capacite_donnees = 2 * l->capacite_donnees > l->taille + st.st_size + 1 ? 2 * l->capacite_donnees : l->taille + st.st_size + 1;
+		l->donnees = realloc(l->donnees, l->capacite_donnees);
+		if (l->donnees == NULL)
+		{
+			assert(0);
+		}
+	}
+	ssize_t lus;
+	do
+	{
+		if (l->taille == l->capacite_donnees) //fichier qui a grossi, ou tube
+		{
+			l->capacite_donnees = l->capacite_donnees > 0 ? 2 * l->capacite_donnees : 1 << 16;
+			l->donnees = realloc(l->donnees, l->capacite_donnees);
+			if (l->donnees == NULL)
+			{
+				assert(0);
+			}
+		}
+		lus = read(fd, l->donnees + l->taille, l->capacite_donnees - l->taille);
+		if (lus < 0)
+		{
+			fprintf(stderr, "Erreur de lecture du fichier %s.\n", chemin);
+			exit(EXIT_FAILURE);
+		}
+		l->taille += lus;
+	} while (lus > 0);
+	if (fd != STDIN_FILENO)
+	{
+		close(fd);
+	}
+	
+	huff_membre *m = &l->membres[l->nb_membres];
+	m->taille = l->taille - debut;
+	m->nom = strdup(nom);
+	if (m->nom == NULL)
+	{
+		assert(0);
+	}
+	l->debuts[l->nb_membres++] = debut;
+}
 
-    	int c;
-    	while ((c = fgetc(in)) != EOF) //on lit le fichier caractère par caractère
-    	{
-        	char *code = codes[c];  //on récupère le code Huffman du caractère dans le tableau codes
-        	if (code != NULL || code[0] != '\0')
-        	{
-			for (int i = 0; code[i] != '\0'; i++) //on parcourt le code huffman bit par bit
-			{ 
-		    		buffer = buffer << 1; //on décale le buffer d'un bit vers la gauche pour faire de la place pour le nouveau bit
-		    		if (code[i] == '1')
-		    		{
-		        		buffer |= 1; //si le bit est '1', on met le bit de poids faible à 1
-		        	}  
-		    		nb_bits++;
+//fonction de comparaison des noms pour qsort : les fichiers d'un répertoire sont ajoutés dans l'ordre alphabétique
+int comparer_noms(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
 
-				//lorsqu'on a atteint les 8 bits dans le buffer, on l'écrit dans le fichier de sortie
-		    		if (nb_bits == 8) 
-		    		{
-		        		if (fputc(buffer, out) == EOF) //si il y a une erreur, fputc renvoie EOF
-		        		{
-				    		fprintf(stderr, "Erreur d'écriture dans le fichier de sortie.\n");
-				    		fclose(in);
-				    		fclose(out);
-				    		return;
-		        		}
-		        		//on réinitialise le buffer et le compteur 
-					buffer = 0;
-					nb_bits = 0;
-		    		}
+//fonction pour ajouter au lot les fichiers réguliers d'un répertoire et de ses sous répertoires, nommés par leur chemin
+//à partir du répertoire de départ (prefixe est le chemin du répertoire en cours, vide au départ)
+void parcourir_repertoire(lot *l, const char *repertoire, const char *prefixe)
+{
+	DIR *r = opendir(repertoire);
+	if (r == NULL)
+	{
+        	fprintf(stderr, "Erreur : impossible d'ouvrir le répertoire %s\n", repertoire);
+        	exit(EXIT_FAILURE);
+	}
+	char **noms = NULL;
+	size_t nb = 0, capacite = 0;
+	struct dirent *f;
+	while ((f = readdir(r)) != NULL)
+	{
+		if (strcmp(f->d_name, ".") == 0 || strcmp(f->d_name, "..") == 0)
+		{
+			continue;
+		}
+		if (nb == capacite)
+		{
+			capacite = capacite > 0 ? 2 * capacite : 16;
+			noms = realloc(noms, capacite * sizeof(char *));
+			if (noms == NULL)
+			{
+				assert(0);
 			}
-        	}
+		}
+		noms[nb] = strdup(f->d_name);
+		if (noms[nb++] == NULL)
+		{
+			assert(0);
+		}
+	}
+	closedir(r);
+	qsort(noms, nb, sizeof(char *), comparer_noms);
+	
+	for (size_t k = 0; k < nb; k++)
+	{
+		//chemin sur le disque et nom dans l'archive, chacun avec son '/' et son zéro final
+		char *chemin = malloc(strlen(repertoire) + strlen(noms[k]) + 2);
+		char *nom = malloc(strlen(prefixe) + strlen(noms[k]) + 2);
+		if (chemin == NULL || nom == NULL)
+		{
+			assert(0);
+		}
+		sprintf(chemin, "%s/%s", repertoire, noms[k]);
+		sprintf(nom, "%s%s%s", prefixe, *prefixe != '\0' ? "/" : "", noms[k]);
+		struct stat st;
+		int existe = lstat(chemin, &st) == 0;
+		if (existe && S_ISDIR(st.st_mode))
+		{
+			parcourir_repertoire(l, chemin, nom);
+		}
+		else if (existe && S_ISREG(st.st_mode)) //les liens symboliques et les fichiers spéciaux sont ignorés
+		{
+			ajouter_fichier(l, chemin, nom);
+		}
+		free(chemin);
+		free(nom);
+		free(noms[k]);
 	}
+	free(noms);
+}
 
-    	if (nb_bits > 0) //si il reste des bits dans le buffer
-    	{
-        	for (int i = 0; i < (8 - nb_bits); i++) 
-        	{
-            		buffer = buffer << 1; //on complète le buffer avec des zéros pour atteindre 8 bits
-        	}
-        	//on écrit le dernier octet dans le fichier de sortie
-       	 	if (fputc(buffer, out) == EOF) 
-       	 	{
-            		fprintf(stderr, "Erreur d'écriture dans le fichier de sortie.\n");
-            		fclose(in);
-            		fclose(out);
-            		return;
-        	}
-    	}
-    	
-    	uint8_t bits_complet; //on va y inscrire le nombre de bits qui font vraiment partis du fichier compressé
-	if (nb_bits > 0)
+//fonction pour ajouter au lot les fichiers d'une liste, un chemin par ligne ("-" pour lire la liste sur l'entrée standard) :
+//chaque membre est nommé par son chemin sans les "/" et "./" du début, comme avec tar, pour être extrait sous le répertoire de sortie
+void lire_liste(lot *l, const char *fichier)
+{
+	FILE *f = strcmp(fichier, "-") == 0 ? stdin : fopen(fichier, "r");
+	if (f == NULL)
 	{
-    		bits_complet = nb_bits;
-    	}
-	else
+        	fprintf(stderr, "Erreur : impossible d'ouvrir la liste %s\n", fichier);
+        	exit(EXIT_FAILURE);
+	}
+	char *ligne = NULL;
+	size_t capacite = 0;
+	ssize_t longueur;
+	while ((longueur = getline(&ligne, &capacite, f)) >= 0)
 	{
-   		bits_complet = 8; 
-   	}
+		while (longueur > 0 && (ligne[longueur - 1] == '\n' || ligne[longueur - 1] == '\r'))
+		{
+			ligne[--longueur] = '\0';
+		}
+		const char *nom = ligne;
+		while (*nom == '/' || (nom[0] == '.' && nom[1] == '/'))
+		{
+			nom += *nom == '/' ? 1 : 2;
+		}
+		if (longueur > 0)
+		{
+			ajouter_fichier(l, ligne, nom);
+		}
+	}
+	free(ligne);
+	if (f != stdin)
+	{
+		fclose(f);
+	}
+}
 
-    	fclose(out);
+//fonction pour compresser un lot de fichiers en une archive : tous les fichiers sont lus une seule fois dans un tampon, puis
+//la bibliothèque les compresse en parallèle (un membre par thread à la fois) et l'archive est écrite en une fois.
+//source est un répertoire, parcouru avec ses sous répertoires, ou une liste de fichiers.
+void compresser_lot(const char *source, const char *sortie, const huff_options *o)
+{
+	lot l = {0};
+	struct stat st;
+	if (stat(source, &st) == 0 && S_ISDIR(st.st_mode))
+	{
+		parcourir_repertoire(&l, source, "");
+	}
+	else
+	{
+		lire_liste(&l, source);
+	}
+	for (size_t i = 0; i < l.nb_membres; i++) //le tampon ne bouge plus
+	{
+		l.membres[i].donnees = l.donnees + l.debuts[i];
+	}
 	
-   	out = fopen(sortie, "rb+"); //on réouvre le fichier de sortie en mode lecture/écriture binaire
-    	if (out == NULL) 
-    	{
-		fprintf(stderr, "Erreur de réouverture du fichier de sortie.\n");
-		fclose(in);
-		return;
-    	}
-
-    	fseek(out, position, SEEK_SET); //on se repositionne à l'endroit où s'arrete l'en tête avec position
-    	fwrite(&bits_complet, sizeof(uint8_t), 1, out); //on écrit les bits vraiment utiles au fichier compressé
-
-    	fclose(in);
-    	fclose(out);
+	size_t taille = huff_lot_taille_max(l.membres, l.nb_membres, o);
+	uint8_t *archive = malloc(taille);
+	if (archive == NULL)
+	{
+		assert(0);
+	}
+	int r = huff_compresser_lot(l.membres, l.nb_membres, archive, &taille, o);
+	if (r != HUFF_OK)
+	{
+		fprintf(stderr, "Erreur : %s.\n", huff_erreur(r));
+		exit(EXIT_FAILURE);
+	}
+	
+	FILE *out = strcmp(sortie, "-") == 0 ? stdout : fopen(sortie, "wb");
+	if (out == NULL)
+	{
+		fprintf(stderr, "Erreur : impossible d'ouvrir le fichier %s pour écriture.\n", sortie);
+		exit(EXIT_FAILURE);
+	}
+	if (ecrire_fichier(out, archive, taille) != 0 || fflush(out) != 0)
+	{
+		fprintf(stderr, "Erreur d'écriture dans le fichier de sortie.\n");
+		exit(EXIT_FAILURE);
+	}
+	if (out != stdout)
+	{
+		fclose(out);
+	}
+	
+	for (size_t i = 0; i < l.nb_membres; i++)
+	{
+		free((char *)l.membres[i].nom);
+	}
+	free(l.membres);
+	free(l.debuts);
+	free(l.donnees);
+	free(archive);
 }
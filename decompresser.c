@@ -1,223 +1,553 @@
 /*Projet Huffman - Compression et Décompression de fichiers en C
 Auteur : Rosselle QUIZON
-Description du code : Implémente la décompression de fichiers en utilisant l'algorithme de Huffman*/
+Description du code : Implémente la décompression de fichiers en utilisant l'algorithme de Huffman (bibliothèque huffman.c)*/
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <errno.h>
 #include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <time.h>
 
-//structure représentant un noeud de l'arbre de Huffman 
-typedef struct _noeud {
-	uint32_t lettre;
-    	uint32_t poids;
-    	struct _noeud *parent;
-    	struct _noeud *gauche;
-   	struct _noeud *droite;
-   	struct _noeud *suivant;
-} noeud;
-
-noeud* creer_noeud();
-void remplace(noeud *racine, const char *code, uint8_t valeur);
-void free_arbre(noeud *racine);
-void decompresser(const char *fichier, const char *sortie);
-
-int main(int argc, char *argv[]) 
+#include "huffman.h"
+#include "outils.h"
+
+#define TAILLE_LECTURE ((size_t)1 << 20) //taille des morceaux lus sur un tube
+#define TAILLE_TAMPON_SORTIE ((size_t)4 << 20) //les blocs décodés en flux sont écrits par paquets de 4 Mo
+
+int ecrire_flux(void *ctx, const void *p, size_t n);
+int ecrire_a(void *ctx, const void *p, size_t n, uint64_t position);
+void decompresser_flux(FILE *in, FILE *out, const huff_options *o, int reserver);
+void reserver_sortie(int fd, uint64_t taille);
+void* projeter_sortie(int fd, uint64_t taille, const char *sortie);
+int lire_intervalle(const char *intervalle, uint64_t *debut, uint64_t *longueur);
+void decompresser(const char *fichier, const char *sortie, const huff_options *o, const char *intervalle, int projection_sortie);
+int decompresser_petit(const uint8_t *src, size_t taille, int out, const huff_options *o);
+int decompresser_fichier(const uint8_t *src, size_t taille, uint64_t taille_sortie, int out, const char *sortie, const huff_options *o);
+void creer_repertoires(char *chemin, size_t debut);
+int nom_valide(const char *nom);
+void decompresser_lot(const char *fichier, const char *repertoire, const huff_options *o);
+
+int main(int argc, char *argv[])
 {
-    	if (argc < 3) 
+    	struct timespec debut;
+    	clock_gettime(CLOCK_MONOTONIC, &debut);
+    	huff_options o;
+    	huff_options_defaut(&o);
+    	huff_stats stats = {0};
+    	const char *intervalle = NULL; //avec --range debut:longueur on ne décode que cette partie du fichier d'origine
+    	int projection_sortie = 0; //avec --mmap-sortie les blocs sont décodés directement dans le fichier de sortie projeté en mémoire
+    	long nb_threads = sysconf(_SC_NPROCESSORS_ONLN); //un thread de décompression par coeur par défaut
+    	int par_lot = 0; //avec --batch on extrait les membres d'une archive dans un répertoire
+    	int a = 1;
+    	while (a < argc && strncmp(argv[a], "--", 2) == 0)
     	{
-        	fprintf(stderr, "Usage: %s fichier_compresse fichier_sortie\n", argv[0]);
+    		if (strcmp(argv[a], "--arbre") == 0) //on décode bit par bit en parcourant l'arbre (version de référence)
+    		{
+    			o.arbre = 1;
+    			a++;
+    		}
+    		else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc)
+    		{
+    			nb_threads = atol(argv[a + 1]);
+    			a += 2;
+    		}
+    		else if (strcmp(argv[a], "--range") == 0 && a + 1 < argc)
+    		{
+    			intervalle = argv[a + 1];
+    			uint64_t debut_intervalle, longueur;
+    			if (!lire_intervalle(intervalle, &debut_intervalle, &longueur)) //vérifié avant d'ouvrir la sortie
+    			{
+				fprintf(stderr, "Erreur : --range attend debut:longueur, deux nombres sans signe.\n");
+				return EXIT_FAILURE;
+    			}
+    			a += 2;
+    		}
+    		else if (strcmp(argv[a], "--mmap-sortie") == 0)
+    		{
+    			projection_sortie = 1;
+    			a++;
+    		}
+    		else if (strcmp(argv[a], "--batch") == 0)
+    		{
+    			par_lot = 1;
+    			a++;
+    		}
+    		else if (strcmp(argv[a], "--stats") == 0) //mesures écrites en JSON sur la sortie d'erreur à la fin
+    		{
+    			o.stats = &stats;
+    			a++;
+    		}
+    		else if (strcmp(argv[a], "--dict") == 0 && a + 1 < argc) //dictionnaire utilisé à la compression
+    		{
+    			o.dictionnaire = charger_dictionnaire(argv[a + 1]);
+    			a += 2;
+    		}
+    		else
+    		{
+        		fprintf(stderr, "Erreur : option inconnue %s\n", argv[a]);
+        		return EXIT_FAILURE;
+    		}
+    	}
+    	o.nb_threads = nb_threads < 1 ? 1 : (int)nb_threads;
+
+    	if (argc - a < 2)
+    	{
+        	fprintf(stderr, "Usage: %s [--arbre] [--threads N] [--range debut:longueur] [--mmap-sortie] [--dict dictionnaire] [--stats] fichier_compresse|- fichier_sortie|-\n", argv[0]);
+        	fprintf(stderr, "       %s --batch [--arbre] [--threads N] [--stats] archive repertoire_sortie\n", argv[0]);
         	return EXIT_FAILURE; //si il n'y a pas le fichier à décompresser et le fichier de sortie dans l'execution
     	}
-    
-    	decompresser(argv[1], argv[2]);
+
+    	if (par_lot)
+    	{
+    		decompresser_lot(argv[a], argv[a + 1], &o);
+    	}
+    	else
+    	{
+    		decompresser(argv[a], argv[a + 1], &o, intervalle, projection_sortie);
+    	}
+    	huff_dictionnaire_liberer((huff_dictionnaire *)o.dictionnaire);
+    	if (o.stats != NULL)
+    	{
+    		afficher_stats("decompresser", o.stats, &debut);
+    	}
     	return EXIT_SUCCESS;
 }
 
-//fonction pour créer un noeud de l'arbre de Huffman
-noeud* creer_noeud() 
+//fonction d'écriture passée au décompresseur en flux : les blocs décodés sont écrits à la suite
+int ecrire_flux(void *ctx, const void *p, size_t n)
 {
-    	noeud *n = malloc(sizeof(noeud));
-    	if (n == NULL) 
-    	{
-       		assert(0);
-    	}
-    	n->lettre = 0; 
-   	n->poids = 0;
-    	n->parent = NULL;
-    	n->gauche = NULL;
-   	n->droite = NULL;
-    	n->suivant = NULL;
-    	return n;
+	return fwrite(p, 1, n, ctx) == n ? 0 : -1;
 }
 
-//fonction qui va insérer les codes huffman dans l'arbre créé en partant de la racine
-void remplace(noeud *racine, const char *code, uint8_t valeur) 
+//fonction d'écriture passée à la décompression parallèle : chaque bloc est écrit directement à sa position
+//dans le fichier de sortie avec pwrite
+int ecrire_a(void *ctx, const void *p, size_t n, uint64_t position)
 {
-    	noeud *n = racine;
-    	for (int i = 0; code[i] != '\0'; i++) 
-    	{
-        	if (code[i] == '0') //si le bit est '0', on va vers le sous-arbre gauche
-        	{
-            		if (n->gauche == NULL)
-            		{
-                		n->gauche = creer_noeud(); //on crée un noeud si ce n'est pas déjà fait
-            		}
-            		n = n->gauche;
-        	} 
-        	else if (code[i] == '1') //si le bit est '1', on va vers le sous-arbre droit
-        	{
-            		if (n->droite == NULL) 
-            		{
-                		n->droite = creer_noeud();
-            		}
-            		n = n->droite;
-        	} 
-        	else 
-        	{
-            		fprintf(stderr, "Erreur: caractère invalide '%c' dans le code Huffman.\n", code[i]);
-            		exit(EXIT_FAILURE);
-        	}
-    	}
-    	n->lettre = valeur; //on affecte le caractère à la feuille à la fin du chemin
+	int fd = *(int *)ctx;
+	const uint8_t *q = p;
+	while (n > 0)
+	{
+		ssize_t ecrits = pwrite(fd, q, n, (off_t)position);
+		if (ecrits <= 0)
+		{
+			return -1;
+		}
+		q += ecrits;
+		n -= ecrits;
+		position += ecrits;
+	}
+	return 0;
 }
 
-//fonction pour libérer la mémoire allouée à l'arbre
-void free_arbre(noeud *racine) 
+//fonction de decompression en flux : on lit l'entrée par morceaux et les blocs sont décodés à la suite
+//jusqu'au marqueur de fin, sans se déplacer dans l'entrée ni dans la sortie. Un seul bloc est en mémoire à la fois.
+//Si reserver est vrai, la place de la sortie est réservée d'après la taille d'origine annoncée dans l'en tête.
+void decompresser_flux(FILE *in, FILE *out, const huff_options *o, int reserver)
 {
-    	if (racine == NULL)
+    	uint8_t *tampon = malloc(TAILLE_LECTURE);
+    	if (tampon == NULL)
     	{
-    		return;
+    		assert(0);
+    	}
+    	huff_decompresseur *d = huff_decompresseur_creer(o, ecrire_flux, out);
+    	if (d == NULL)
+    	{
+		fprintf(stderr, "Erreur : %s.\n", huff_erreur(HUFF_ERREUR_MEMOIRE));
+		exit(EXIT_FAILURE);
+    	}
+
+    	int r = HUFF_OK;
+    	size_t lus;
+    	uint64_t taille_annoncee;
+    	while (r == HUFF_OK && (lus = fread(tampon, 1, TAILLE_LECTURE, in)) > 0)
+    	{
+    		if (reserver && huff_lire_en_tete(tampon, lus, &taille_annoncee) == HUFF_OK && taille_annoncee != HUFF_TAILLE_INCONNUE)
+    		{
+    			reserver_sortie(fileno(out), taille_annoncee);
+    		}
+    		reserver = 0; //seul le premier morceau contient l'en tête
+    		r = huff_decompresseur_ecrire(d, tampon, lus);
+    	}
+    	if (r == HUFF_OK)
+    	{
+    		r = huff_decompresseur_terminer(d);
+    	}
+    	huff_decompresseur_liberer(d);
+    	free(tampon);
+
+    	if (r == HUFF_ERREUR_ECRITURE || fflush(out) != 0)
+    	{
+		fprintf(stderr, "Erreur d'écriture dans le fichier de sortie.\n");
+		exit(EXIT_FAILURE);
+    	}
+    	if (r != HUFF_OK)
+    	{
+		fprintf(stderr, "Erreur : %s.\n", huff_erreur(r));
+		exit(EXIT_FAILURE);
     	}
-    	free_arbre(racine->gauche);
-    	free_arbre(racine->droite);
-    	free(racine);
 }
 
-//fonction principale de decompression
-void decompresser(const char *fichier, const char *sortie) 
+//fonction pour réserver la place de la sortie sur le disque en une fois, avant l'écriture des blocs :
+//le système de fichiers peut la placer d'un seul tenant. Un échec n'est pas une erreur, l'écriture allouera la place.
+void reserver_sortie(int fd, uint64_t taille)
 {
-    	FILE *in = fopen(fichier, "rb"); //on lit le fichier d'entrée en mode binaire
-    	if (in == NULL) 
+	if (taille > 0)
+	{
+		posix_fallocate(fd, 0, (off_t)taille);
+	}
+}
+
+//fonction pour dimensionner le fichier de sortie et le projeter en mémoire en écriture, NULL si taille vaut 0
+void* projeter_sortie(int fd, uint64_t taille, const char *sortie)
+{
+	reserver_sortie(fd, taille);
+	if (ftruncate(fd, (off_t)taille) != 0)
+	{
+		fprintf(stderr, "Erreur : impossible de dimensionner le fichier %s.\n", sortie);
+		exit(EXIT_FAILURE);
+	}
+	if (taille == 0) //mmap refuse une projection de taille nulle
+	{
+		return NULL;
+	}
+	void *p = mmap(NULL, taille, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (p == MAP_FAILED)
+	{
+		fprintf(stderr, "Erreur : impossible de projeter le fichier %s en mémoire.\n", sortie);
+		exit(EXIT_FAILURE);
+	}
+	return p;
+}
+
+//fonction principale de decompression : le fichier compressé est projeté en mémoire, puis la bibliothèque lit l'index
+//à la fin du fichier et décode les blocs en parallèle. Avec projection_sortie, la sortie est dimensionnée d'après la taille
+//d'origine lue dans l'index puis projetée en mémoire, et les blocs y sont décodés directement, sans tampon ni appel à pwrite.
+//Un petit fichier est décodé sans threads par decompresser_petit.
+//Si l'entrée ou la sortie est un tube ("-" pour l'entrée ou la sortie standard), on décompresse en flux.
+//fonction pour lire l'intervalle debut:longueur de --range : deux nombres décimaux sans signe ni espace, sans rien après
+//(strtoull accepterait un signe moins, qui fait le tour des valeurs, et un champ vide). Elle renvoie 0 si l'intervalle est invalide.
+int lire_intervalle(const char *intervalle, uint64_t *debut, uint64_t *longueur)
+{
+	char *fin;
+	if (intervalle[0] < '0' || intervalle[0] > '9')
+	{
+		return 0;
+	}
+	errno = 0;
+	*debut = strtoull(intervalle, &fin, 10);
+	if (*fin != ':' || fin[1] < '0' || fin[1] > '9' || errno == ERANGE)
+	{
+		return 0;
+	}
+	*longueur = strtoull(fin + 1, &fin, 10);
+	return *fin == '\0' && errno != ERANGE;
+}
+
+void decompresser(const char *fichier, const char *sortie, const huff_options *o, const char *intervalle, int projection_sortie)
+{
+    	int in = strcmp(fichier, "-") == 0 ? STDIN_FILENO : open(fichier, O_RDONLY); //on lit le fichier d'entrée en mode binaire
+    	if (in < 0)
     	{
         	fprintf(stderr, "Erreur : impossible d'ouvrir le fichier %s\n", fichier);
         	exit(EXIT_FAILURE);
     	}
-    	
-    	FILE *out = fopen(sortie, "wb"); //on va écrire dans le fichier de sortie en mode binaire 
-    	if (out == NULL) 
+
+    	struct stat st;
+    	int flux = strcmp(sortie, "-") == 0 || fstat(in, &st) != 0 || !S_ISREG(st.st_mode);
+    	if (flux)
+    	{
+    		if (intervalle != NULL)
+    		{
+			fprintf(stderr, "Erreur : --range demande un fichier compressé régulier et une sortie dans un fichier.\n");
+			exit(EXIT_FAILURE);
+    		}
+    		FILE *f_in = fdopen(in, "rb");
+    		FILE *f_out = strcmp(sortie, "-") == 0 ? stdout : fopen(sortie, "wb");
+    		if (f_in == NULL || f_out == NULL)
+    		{
+			fprintf(stderr, "Erreur : impossible d'ouvrir le fichier %s pour écriture.\n", sortie);
+			exit(EXIT_FAILURE);
+    		}
+    		setvbuf(f_out, NULL, _IOFBF, TAILLE_TAMPON_SORTIE); //les petits blocs sont regroupés en grosses écritures
+    		decompresser_flux(f_in, f_out, o, f_out != stdout); //la sortie standard peut être ouverte en ajout
+    		if (f_out != stdout)
+    		{
+    			fclose(f_out);
+    		}
+    		return;
+    	}
+
+    	size_t taille = st.st_size;
+    	const uint8_t *src = (const uint8_t *)""; //mmap refuse une projection de taille nulle
+    	void *projection = NULL;
+    	if (taille > 0)
+    	{
+    		projection = mmap(NULL, taille, PROT_READ, MAP_PRIVATE, in, 0);
+    		if (projection == MAP_FAILED)
+    		{
+			fprintf(stderr, "Erreur : impossible de projeter le fichier %s en mémoire.\n", fichier);
+			exit(EXIT_FAILURE);
+    		}
+    		src = projection;
+    	}
+
+    	uint64_t taille_sortie;
+    	int r = huff_taille_originale(src, taille, &taille_sortie);
+    	if (r != HUFF_OK)
+    	{
+		fprintf(stderr, "Erreur : %s.\n", huff_erreur(r));
+		exit(EXIT_FAILURE);
+    	}
+
+    	int out = open(sortie, (projection_sortie ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC, 0644); //on va écrire dans le fichier de sortie
+    	if (out < 0)
     	{
 		fprintf(stderr, "Erreur : impossible d'ouvrir le fichier %s pour écriture.\n", sortie);
-		fclose(in);
 		exit(EXIT_FAILURE);
     	}
-    
-    	uint16_t nb_codes;
-    	if (fread(&nb_codes, sizeof(uint16_t), 1, in) != 1) //on va lire le nombre de codes stockés dans l'en tête 
+
+    	if (intervalle != NULL)
     	{
-        	fprintf(stderr, "Erreur lors de la lecture du nombre de codes.\n");
-        	fclose(in);
-        	exit(EXIT_FAILURE);
+    		uint64_t debut, longueur;
+    		lire_intervalle(intervalle, &debut, &longueur); //déjà vérifié avec les options
+    		if (debut > taille_sortie) //l'intervalle est ramené à la taille du fichier d'origine
+    		{
+    			debut = taille_sortie;
+    		}
+    		if (longueur > taille_sortie - debut)
+    		{
+    			longueur = taille_sortie - debut;
+    		}
+
+    		size_t n = longueur;
+    		if (projection_sortie)
+    		{
+    			uint8_t vide[1]; //destination d'un intervalle vide
+    			uint8_t *dst = projeter_sortie(out, longueur, sortie);
+    			r = huff_decompresser_intervalle(src, taille, debut, &n, dst != NULL ? dst : vide, o);
+    			if (dst != NULL)
+    			{
+    				munmap(dst, longueur);
+    			}
+    		}
+    		else
+    		{
+    			uint8_t *tampon = malloc(n + 1);
+    			if (tampon == NULL)
+    			{
+    				assert(0);
+    			}
+    			r = huff_decompresser_intervalle(src, taille, debut, &n, tampon, o);
+    			if (r == HUFF_OK && ecrire_a(&out, tampon, n, 0) != 0)
+    			{
+    				r = HUFF_ERREUR_ECRITURE;
+    			}
+    			free(tampon);
+    		}
     	}
- 
-    	char codes[256][32] = {0}; //on déclare un tableau pour stocker les codes Huffman pour chaque caractère
-    	
-    	for (int i = 0; i < nb_codes; i++) 
+    	else if (projection_sortie)
+    	{
+    		uint8_t vide[1]; //destination d'un fichier d'origine vide
+    		uint8_t *dst = projeter_sortie(out, taille_sortie, sortie);
+    		size_t n = taille_sortie;
+    		r = huff_decompresser(src, taille, dst != NULL ? dst : vide, &n, o);
+    		if (dst != NULL)
+    		{
+    			munmap(dst, taille_sortie);
+    		}
+    	}
+    	else
     	{
-		uint8_t valeur;
-		uint8_t longueur;
-		
-		if (fread(&valeur, sizeof(uint8_t), 1, in) != 1) //on lit la valeur du code ascii du caractère
+    		r = decompresser_fichier(src, taille, taille_sortie, out, sortie, o);
+    	}
+
+    	if (projection != NULL)
+    	{
+    		munmap(projection, taille);
+    	}
+    	close(in);
+    	if (r == HUFF_ERREUR_ECRITURE || close(out) != 0)
+    	{
+		fprintf(stderr, "Erreur d'écriture dans le fichier de sortie.\n");
+		exit(EXIT_FAILURE);
+    	}
+    	if (r != HUFF_OK)
+    	{
+		fprintf(stderr, "Erreur : %s.\n", huff_erreur(r));
+		exit(EXIT_FAILURE);
+    	}
+}
+
+//fonction pour décompresser des données en mémoire dans le fichier out : un petit fichier passe par decompresser_petit,
+//sinon la sortie est dimensionnée d'après taille_sortie et les blocs y sont écrits en parallèle avec pwrite
+int decompresser_fichier(const uint8_t *src, size_t taille, uint64_t taille_sortie, int out, const char *sortie, const huff_options *o)
+{
+	int r = HUFF_ERREUR_CONTEXTE;
+	if (taille <= HUFF_PETIT_MAX && taille_sortie <= HUFF_PETIT_MAX)
+	{
+		r = decompresser_petit(src, taille, out, o);
+	}
+	if (r == HUFF_ERREUR_CONTEXTE) //gros fichier, ou blocs qu'un huff_contexte ne peut pas décoder
+	{
+		reserver_sortie(out, taille_sortie);
+		if (ftruncate(out, (off_t)taille_sortie) != 0) //le fichier de sortie a sa taille finale avant l'écriture des blocs
 		{
-		    fprintf(stderr, "Erreur lors de la lecture d'une valeur.\n");
-		    fclose(in);
-		    exit(EXIT_FAILURE);
-		}
-		
-		if (fread(&longueur, sizeof(uint8_t), 1, in) != 1) { //on lit la longueur du code huffman associé
-		    fprintf(stderr, "Erreur lors de la lecture de la longueur d'un code.\n");
-		    fclose(in);
-		    exit(EXIT_FAILURE);
+			fprintf(stderr, "Erreur : impossible de dimensionner le fichier %s.\n", sortie);
+			exit(EXIT_FAILURE);
 		}
-		
-		if (fread(codes[valeur], sizeof(char), longueur, in) != longueur) //on lit le code huffman
+		r = huff_decompresser_vers(src, taille, ecrire_a, &out, o);
+	}
+	return r;
+}
+
+//fonction pour créer les répertoires du chemin d'un fichier à extraire, à partir de la position debut (le répertoire de sortie existe)
+void creer_repertoires(char *chemin, size_t debut)
+{
+	for (char *p = chemin + debut; (p = strchr(p, '/')) != NULL; p++)
+	{
+		*p = '\0';
+		mkdir(chemin, 0755); //un répertoire déjà présent n'est pas une erreur, l'ouverture du fichier échouera s'il manque
+		*p = '/';
+	}
+}
+
+//fonction qui vérifie qu'un nom de membre reste dans le répertoire de sortie : relatif, sans composant vide, "." ni ".."
+int nom_valide(const char *nom)
+{
+	if (*nom == '\0' || *nom == '/')
+	{
+		return 0;
+	}
+	for (const char *p = nom; *p != '\0'; )
+	{
+		size_t n = strcspn(p, "/");
+		if (n == 0 || (n == 1 && p[0] == '.') || (n == 2 && p[0] == '.' && p[1] == '.'))
 		{
-		    fprintf(stderr, "Erreur lors de la lecture du code %d.\n", valeur);
-		    fclose(in);
-		    exit(EXIT_FAILURE);
+			return 0;
 		}
-		
-		codes[valeur][longueur] = '\0'; //pour marquer la fin du code Huffman lu et stocké dans codes[valeur]
+		p += n;
+		p += *p == '/';
+	}
+	return nom[strlen(nom) - 1] != '/';
+}
+
+//fonction pour extraire tous les membres d'une archive écrite par compresser --batch dans un répertoire : l'archive est projetée
+//en mémoire, chaque membre est décodé avec le dictionnaire de l'archive et écrit sous son nom, sous répertoires compris.
+//Un membre sans nom est écrit sous le nom membre_i.
+void decompresser_lot(const char *fichier, const char *repertoire, const huff_options *o)
+{
+    	int in = open(fichier, O_RDONLY);
+    	struct stat st;
+    	if (in < 0 || fstat(in, &st) != 0 || !S_ISREG(st.st_mode))
+    	{
+        	fprintf(stderr, "Erreur : impossible d'ouvrir l'archive %s (--batch demande un fichier régulier)\n", fichier);
+        	exit(EXIT_FAILURE);
+    	}
+    	size_t taille = st.st_size;
+    	const uint8_t *src = (const uint8_t *)"";
+    	void *projection = NULL;
+    	if (taille > 0)
+    	{
+    		projection = mmap(NULL, taille, PROT_READ, MAP_PRIVATE, in, 0);
+    		if (projection == MAP_FAILED)
+    		{
+			fprintf(stderr, "Erreur : impossible de projeter le fichier %s en mémoire.\n", fichier);
+			exit(EXIT_FAILURE);
+    		}
+    		src = projection;
     	}
-    
-    	uint8_t bits_complet;
-    	if (fread(&bits_complet, sizeof(uint8_t), 1, in) != 1) //on récupère le nombre de bits du dernier octet qui font partis du fichier compressé
+    	
+    	uint32_t nb_membres;
+    	huff_dictionnaire *d;
+    	int r = huff_lot_lire(src, taille, &nb_membres, &d);
+    	if (r != HUFF_OK)
     	{
-		fprintf(stderr, "Erreur lors de la lecture du bits_complet.\n");
-		fclose(in);
+		fprintf(stderr, "Erreur : %s.\n", huff_erreur(r));
 		exit(EXIT_FAILURE);
     	}
- 
-    	noeud *racine = creer_noeud(); //on va reconstruire l'arbre des codes Huffman à partir du tableau codes
-
-    	for (int i = 0; i < 256; i++) 
+    	huff_options ol = *o;
+    	if (d != NULL) //les membres ont été compressés avec le dictionnaire de l'archive
     	{
-        	if (codes[i][0] != '\0') 
-        	{
-            		remplace(racine, codes[i], (uint8_t)i);
-        	}
+    		ol.dictionnaire = d;
     	}
+    	mkdir(repertoire, 0755);
     	
-    	long position_debut = ftell(in); //position actuelle juste après l'en-tête
-    	fseek(in, 0, SEEK_END);
-    	long position_fin = ftell(in);  //position finale du fichier
-    	long taillevraie = position_fin - position_debut; //on récupère la taille du fichier compressé
-    	
-    	fseek(in, position_debut, SEEK_SET); //on revient au debut du fichier
-    
-    	noeud *n = racine;  
-    	unsigned char octet;
-    	int nb_bits; //nombre de bits à lire dans l'octet courant
-    	int bit;
+    	for (uint32_t i = 0; i < nb_membres; i++)
+    	{
+    		huff_info_membre m;
+    		r = huff_lot_membre(src, taille, i, &m);
+    		if (r != HUFF_OK)
+    		{
+			fprintf(stderr, "Erreur : %s.\n", huff_erreur(r));
+			exit(EXIT_FAILURE);
+    		}
+    		char *chemin = malloc(strlen(repertoire) + m.longueur_nom + 32);
+    		if (chemin == NULL)
+    		{
+    			assert(0);
+    		}
+    		size_t debut = sprintf(chemin, "%s/", repertoire);
+    		if (m.longueur_nom > 0)
+    		{
+    			memcpy(chemin + debut, m.nom, m.longueur_nom);
+    			chemin[debut + m.longueur_nom] = '\0';
+    		}
+    		else
+    		{
+    			sprintf(chemin + debut, "membre_%u", i);
+    		}
+    		if (memchr(m.nom, '\0', m.longueur_nom) != NULL || !nom_valide(chemin + debut))
+    		{
+			fprintf(stderr, "Erreur : nom de membre invalide dans l'archive %s.\n", fichier);
+			exit(EXIT_FAILURE);
+    		}
+    		creer_repertoires(chemin, debut);
+    		
+    		int out = open(chemin, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    		if (out < 0)
+    		{
+			fprintf(stderr, "Erreur : impossible d'ouvrir le fichier %s pour écriture.\n", chemin);
+			exit(EXIT_FAILURE);
+    		}
+    		r = decompresser_fichier(m.donnees, m.taille, m.taille_originale, out, chemin, &ol);
+    		if (r == HUFF_ERREUR_ECRITURE || close(out) != 0)
+    		{
+			fprintf(stderr, "Erreur d'écriture dans le fichier %s.\n", chemin);
+			exit(EXIT_FAILURE);
+    		}
+    		if (r != HUFF_OK)
+    		{
+			fprintf(stderr, "Erreur : %s (membre %s).\n", huff_erreur(r), chemin + debut);
+			exit(EXIT_FAILURE);
+    		}
+    		free(chemin);
+    	}
     	
-        int i = 0; //compteur pour identifier le dernier octet
-        while (fread(&octet, sizeof(unsigned char), 1, in) != 0) 
-        {
-
-        
-        	if (i == taillevraie - 1) 
-        	{
-            		nb_bits = bits_complet; //pour le dernier octet
-		}
-       	 	else
-       	 	{
-      			nb_bits = 8;
-      		}
-
-        	for (int j = 7; j >= (8 - nb_bits); j--) //on parcourt des bits de l'octet en partant du bit de poids fort (jusqu'au bit 8-nb_bits pour le dernier octet)
-        	{
-            		bit = (octet >> j) % 2;
-            		if (bit == 0)
-            		{
-                		n = n->gauche;
-			}
-            		else
-            		{
-                		n = n->droite;
-                	}
-            
-            		if (n->gauche == NULL && n->droite == NULL) //quand on a atteint une feuille, on a réussi à retrouver un caractère du fichier d'origine
-            		{
-		        	uint8_t valeur = (uint8_t) n->lettre;
-		        	fwrite(&valeur, sizeof(uint8_t), 1, out); //on écrit ce caractère dans le fichier de sortie
-		        	n = racine; //on revient à la racine pour le prochain caractère
-            		}
-        	}
-        	i++;
-        }
-    
-    	fclose(in);
-    	fclose(out);
-    	free_arbre(racine);
+    	huff_dictionnaire_liberer(d);
+    	if (projection != NULL)
+    	{
+    		munmap(projection, taille);
+    	}
+    	close(in);
+}
+
+//fonction pour décompresser un petit fichier avec un huff_contexte : les blocs sont décodés dans le thread appelant,
+//sans allocation, dans un tampon écrit en une fois. Elle renvoie le code de retour de la bibliothèque.
+int decompresser_petit(const uint8_t *src, size_t taille, int out, const huff_options *o)
+{
+	static huff_contexte ctx;
+	static uint8_t tampon[HUFF_PETIT_MAX];
+	size_t n = sizeof(tampon);
+	int r = huff_decompresser_petit(&ctx, src, taille, tampon, &n, o);
+	if (r == HUFF_OK && ecrire_a(&out, tampon, n, 0) != 0)
+	{
+		r = HUFF_ERREUR_ECRITURE;
+	}
+	return r;
 }
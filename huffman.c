@@ -0,0 +1,4604 @@
+/*Projet Huffman - Compression et Décompression de fichiers en C
+Auteur : Rosselle QUIZON
+Description du code : Bibliothèque de compression et de décompression de Huffman (libhuffman), sans accès aux fichiers :
+les données sont lues et écrites en mémoire ou passées à des fonctions d'écriture fournies par l'appelant*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HISTO_AVX2 1 //le noyau AVX2 est compilé, il n'est utilisé que si le processeur le supporte
+#endif
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CRC_SSE42 1 //instruction crc32 de SSE4.2, utilisée seulement si le processeur la supporte
+#endif
+
+#include "huffman.h"
+
+#define NB_SYMBOLES_MAX (256 + 2) //les 256 caractères, plus les 2 symboles de longueur de plage des blocs BLOC_PLAGES
+#define NB_NOEUDS_MAX (2 * NB_SYMBOLES_MAX - 1) //une feuille par symbole et au plus une de moins de noeuds internes
+#define SYMBOLE_PLAGE_A 256 //chiffres 1 et 2 de la longueur d'une plage, écrite en base 2 bijective (comme RUNA et RUNB de bzip2)
+#define SYMBOLE_PLAGE_B 257
+#define AUCUN 0xFFFF //indice d'enfant d'une feuille
+
+//structure représentant un noeud de l'arbre de Huffman, les enfants sont des indices dans arbre.noeuds
+typedef struct
+{
+	uint64_t poids; //Nombre d'apparitions du caractère
+	uint16_t lettre; //Code ASCII du caractère, ou symbole au delà de 255
+	uint16_t gauche;
+	uint16_t droite;
+} noeud;
+
+//structure représentant l'arbre de Huffman dans un tableau contigu :
+//les feuilles triées par poids croissant, puis les noeuds internes dans l'ordre de leur création
+typedef struct
+{
+	noeud noeuds[NB_NOEUDS_MAX];
+	uint16_t nb_feuilles;
+	uint16_t nb_noeuds;
+	uint16_t racine; //AUCUN si le fichier est vide
+} arbre;
+
+#define LONGUEUR_MAX HUFF_LONGUEUR_MAX
+#define TABLE_BITS 11 //nombre de bits lus d'un coup pour chaque niveau de la table de décodage
+#define HISTO_SOUS_TABLES 4 //nombre de sous-histogrammes entrelacés, fusionnés à la fin du comptage
+#define HISTO_BLOC ((size_t)1 << 30) //les sous-histogrammes en 32 bits sont fusionnés au plus tous les 1 Go
+#define HISTO_PETIT 1024 //les zones plus petites sont comptées directement, sans sous-histogrammes
+#define HISTO_SAUT_MAX 1024 //le noyau AVX2 compte au plus 1 Ko avec le noyau scalaire entre deux recherches de plage
+#define ECHANTILLON_MORCEAUX 16 //morceaux comptés pour estimer si un bloc est incompressible
+#define ECHANTILLON_MORCEAU 1024
+#define ECHANTILLON_BLOC_MIN ((size_t)1 << 16) //les blocs plus petits sont toujours comptés en entier
+
+//formats de l'en tête : il ne contient que les longueurs des codes, les codes canoniques en sont déduits
+#define EN_TETE_QUARTETS 0 //256 longueurs de 4 bits, deux par octet (codes de 15 bits au plus)
+#define EN_TETE_OCTETS 1 //256 longueurs d'un octet
+#define EN_TETE_EPARSE 2 //nombre de caractères présents puis un couple (caractère, longueur) pour chacun
+#define EN_TETE_TAILLE_MAX (1 + 256) //taille maximale de l'en tête des longueurs
+
+//format des données compressées : l'en tête du fichier, les blocs, le marqueur de fin, puis l'index des blocs, puis le pied qui donne
+//la position de l'index. Chaque bloc porte le CRC32C de ses données d'origine, vérifié après le décodage.
+//Un bloc a sa propre table, ou réutilise celle du dernier bloc qui en a une, ou est stocké brut, ou n'est qu'un caractère répété. Les entiers sont écrits en petit-boutiste.
+//Les blocs se délimitent eux-mêmes : on peut les lire à la suite sur un tube jusqu'au marqueur de fin, sans l'index.
+#define BLOC_TABLE 0 //type de bloc : en tête des longueurs puis données codées
+#define BLOC_DICTIONNAIRE 1 //type de bloc : identifiant du dictionnaire (4 octets) puis données codées avec ses codes
+#define BLOC_REUTILISE 2 //type de bloc : données codées avec la table du dernier bloc BLOC_TABLE qui le précède
+#define BLOC_BRUT 3 //type de bloc : données d'origine telles quelles
+#define BLOC_CONSTANT 4 //type de bloc : un seul octet, répété sur toute la taille d'origine
+#define BLOC_CONTEXTE 5 //type de bloc : groupes des contextes, en tête des longueurs de chaque groupe, puis données codées (ordre 1)
+#define BLOC_PLAGES 6 //type de bloc : en tête des longueurs des caractères, longueurs des 2 symboles de plage, puis caractères et plages codés en un flux
+#define BLOC_4_FLUX 0x80 //ajouté au type d'un bloc codé : les données codées sont en 4 flux entrelacés
+#define TYPE_BLOC(t) ((t) & ~BLOC_4_FLUX)
+#define TAILLE_TABLE_SAUT 12 //taille des 3 premiers flux d'un bloc en 4 flux (4 octets chacune), le 4e va jusqu'à la fin du bloc
+#define FLUX_SURCOUT (TAILLE_TABLE_SAUT + 3) //table de saut et octets incomplets des 3 premiers flux
+#define FLUX_BLOC_MIN ((size_t)1 << 14) //les blocs plus petits sont codés en un seul flux
+#define BLOC_FIN 0xFF //marqueur de fin des blocs (un seul octet)
+#define TAILLE_EN_TETE_BLOC 13 //type (1 octet), taille d'origine (4 octets), taille du reste du bloc (4 octets), CRC32C (4 octets)
+#define TAILLE_ENTREE_INDEX 16 //position du bloc (8 octets), taille compressée (4 octets), taille d'origine (4 octets)
+#define TAILLE_PIED 20 //nombre de blocs (4 octets), position de l'index (8 octets), taille d'origine (8 octets)
+#define MAGIC_FICHIER 0x46465548u //"HUFF" en petit-boutiste
+#define VERSION_FORMAT 1
+#define TAILLE_EN_TETE_FICHIER HUFF_TAILLE_EN_TETE //magic (4 octets), version (1 octet), taille d'origine (8 octets, HUFF_TAILLE_INCONNUE en flux)
+//message court : les données qui tiennent dans un bloc codé avec un dictionnaire sont écrites sans en tête de fichier, marqueur de fin,
+//index ni pied, seulement ce magic suivi du bloc (21 octets autour des données codées au lieu de 67)
+#define MAGIC_MESSAGE 0x4D465548u //"HUFM" en petit-boutiste
+#define TAILLE_EN_TETE_MESSAGE 4 //magic (4 octets), le bloc suit
+
+//archive d'un lot : en tête, dictionnaire éventuel, membres compressés à la suite, index des membres, noms des membres puis pied
+#define MAGIC_LOT 0x4C465548u //"HUFL" en petit-boutiste
+#define VERSION_LOT 1
+#define TAILLE_EN_TETE_LOT 7 //magic (4 octets), version (1 octet), taille du dictionnaire (2 octets, 0 sans dictionnaire)
+#define TAILLE_ENTREE_LOT 28 //position du membre (8 octets), taille compressée (8 octets), taille d'origine (8 octets), fin de son nom (4 octets)
+#define TAILLE_PIED_LOT 16 //position de l'index (8 octets), nombre de membres (4 octets), magic (4 octets)
+
+//mode d'ordre 1 : chaque caractère est codé avec la table du groupe de son contexte, le caractère qui le précède (0 au début de chaque flux).
+//Les contextes sont répartis en au plus NB_GROUPES_MAX groupes pour que les en têtes restent petits.
+#define NB_GROUPES_MAX 16
+#define EN_TETE_CONTEXTE_MAX (1 + 128 + NB_GROUPES_MAX * EN_TETE_TAILLE_MAX) //nombre de groupes, groupe de chaque contexte sur 4 bits, longueurs des groupes
+#define CONTEXTE_BLOC_MIN ((size_t)1 << 12) //les blocs plus petits ne paient pas l'en tête des groupes
+#define ITERATIONS_GROUPES 8 //passes au plus pour répartir les contextes en groupes
+
+//tables de décodage de capacité fixe (huff_contexte) : avec des codes de 15 bits au plus, chaque sous-table a au plus 16 entrées
+//et chacun des 256 caractères ouvre au plus une sous-table, la table ne dépasse donc jamais TABLE_FIXE_CAPACITE entrées
+#define LONGUEUR_FIXE_MAX HUFF_LONGUEUR_CONTEXTE //TABLE_BITS + 4
+#define TABLE_FIXE_CAPACITE ((1 << TABLE_BITS) + 256 * (1 << (LONGUEUR_FIXE_MAX - TABLE_BITS)))
+
+//structure pour stocker un code Huffman sous forme d'entier
+typedef struct
+{
+	uint32_t bits; //les bits du code, alignés sur le bit de poids faible
+	uint8_t longueur; //nombre de bits du code
+} code_huffman;
+
+//structure représentant une entrée de la table de décodage
+typedef struct {
+	uint32_t valeur; //caractère décodé, ou position de la sous-table si sous_bits > 0
+	uint8_t longueur; //nombre de bits consommés à ce niveau (0 si aucun code ne commence ainsi)
+	uint8_t sous_bits; //nombre de bits indexant la sous-table (0 pour une feuille)
+} entree_table;
+
+//structure pour stocker la table de décodage : une table principale suivie de ses sous-tables
+typedef struct {
+	entree_table *entrees;
+	uint32_t taille;
+	uint32_t capacite;
+	uint8_t largeur; //nombre de bits indexant la table principale
+	uint8_t lg_max; //longueur du code le plus long
+} table_decodage;
+
+//structure représentant la position d'un décodeur dans un flux de bits
+typedef struct {
+	const uint8_t *p; //prochain octet à charger dans le réservoir
+	const uint8_t *fin;
+	uint64_t reservoir; //les prochains bits à décoder sont rangés à partir du bit de poids fort
+	int nb_bits; //nombre de bits valides dans le réservoir
+} lecteur_bits;
+
+//structure pour chronométrer les phases d'un thread : instant de la dernière mesure, en temps écoulé et en temps processeur
+typedef struct {
+	uint64_t reel;
+	uint64_t cpu;
+} chrono;
+
+//structure pour compter les caractères d'un bloc selon leur contexte, avec la liste des caractères présents après chaque contexte
+typedef struct {
+	uint32_t apparitions[256][256]; //apparitions[c][s] : nombre de fois où s suit c
+	uint64_t total[256]; //nombre de caractères après chaque contexte
+	uint8_t symboles[256][256];
+	uint16_t nb_symboles[256];
+} histogramme_contexte;
+
+//structure du modèle d'ordre 1 d'un bloc : le groupe de chaque contexte et les longueurs des codes de chaque groupe
+typedef struct {
+	int nb_groupes;
+	uint8_t groupe[256];
+	uint8_t longueurs[NB_GROUPES_MAX][256];
+} modele_contexte;
+
+//structure pour décoder un bloc BLOC_CONTEXTE : la table de chaque groupe, et pour chaque contexte la table de son groupe
+typedef struct {
+	int nb_groupes;
+	table_decodage *tables[NB_GROUPES_MAX];
+	const table_decodage *contextes[256];
+	int lg_max; //longueur du plus long code de tous les groupes
+} tables_contexte;
+
+//structure pour garder la table du dernier bloc BLOC_TABLE décodé, réutilisée par les blocs BLOC_REUTILISE qui le suivent
+typedef struct {
+	uint8_t longueurs[256];
+	table_decodage *table; //NULL si aucune table n'est chargée
+	uint32_t bloc; //numéro du bloc dont vient la table pour les décodages par l'index, UINT32_MAX sinon
+	table_decodage *fixe; //si non NULL, table de capacité fixe où la table est construite au lieu d'être allouée (huff_contexte)
+} table_courante;
+
+//structure rangée dans un huff_contexte : tout l'état d'une compression ou d'une décompression sans allocation
+typedef struct {
+	uint64_t apparitions[256];
+	uint8_t longueurs[256];
+	code_huffman codes[256];
+	table_courante tc;
+	table_decodage table;
+	entree_table entrees[TABLE_FIXE_CAPACITE];
+} contexte_petit;
+
+//structure d'un dictionnaire : une table de longueurs calculée sur des échantillons, avec les codes et la table de décodage
+//construits une seule fois. Tous les caractères y ont un code, même ceux absents des échantillons.
+struct huff_dictionnaire {
+	uint64_t apparitions[256]; //nombre d'apparitions de chaque caractère dans les échantillons
+	uint8_t longueurs[256];
+	code_huffman codes[256];
+	uint8_t lg_max;
+	table_decodage *table; //NULL tant que le dictionnaire n'est pas entraîné ou lu
+	uint32_t id;
+};
+
+//structure représentant un bloc en cours de compression, le bloc numéro i occupe l'emplacement i % fenetre
+typedef struct {
+	const uint8_t *donnees; //bloc à compresser, dans le tampon ou dans la mémoire de l'appelant
+	size_t taille;
+	uint8_t *tampon; //le bloc y est copié quand il est passé par morceaux
+	uint8_t *resultat; //bloc compressé
+	size_t taille_resultat;
+	int pret; //1 quand le bloc a été compressé
+} emplacement;
+
+//structure d'un compresseur en flux : le thread appelant remplit les blocs et les écrit dans l'ordre,
+//les threads les compressent dans l'ordre où ils sont remplis. Au plus fenetre blocs sont en mémoire à la fois.
+struct huff_compresseur {
+	huff_options o;
+	huff_ecrire ecrire;
+	void *ctx;
+	emplacement *emplacements;
+	uint32_t fenetre;
+	size_t partiel; //nombre d'octets déjà copiés dans le bloc en cours de remplissage
+	uint64_t lus; //nombre de blocs remplis
+	uint64_t suivant; //prochain bloc à compresser
+	uint64_t ecrits; //nombre de blocs déjà écrits
+	uint64_t position; //position du prochain bloc dans la sortie, 0 tant que l'en tête du fichier n'est pas écrit
+	uint64_t taille_annoncee; //taille d'origine écrite dans l'en tête, HUFF_TAILLE_INCONNUE si elle n'a pas été donnée
+	uint64_t taille_totale; //somme des tailles des blocs écrits
+	huff_stats stats; //mesures des écritures faites par le thread appelant, ajoutées à o.stats à la fin
+	uint8_t *index; //index des blocs écrits, suivi de la place pour le pied
+	size_t capacite_index;
+	pthread_t *threads; //NULL si on compresse dans le thread appelant
+	uint64_t choisis; //nombre de blocs dont le codage est choisi
+	uint8_t longueurs[256]; //table du dernier bloc qui en a une, réutilisable par le bloc suivant
+	int table_valide;
+	int fin_entree;
+	int erreur;
+	pthread_mutex_t verrou;
+	pthread_cond_t bloc_lu;
+	pthread_cond_t bloc_pret;
+	pthread_cond_t table_choisie;
+};
+
+//structure représentant un bloc de l'index, avec sa position dans les données décompressées
+typedef struct {
+	uint64_t position; //position du bloc dans les données compressées
+	uint64_t position_sortie; //somme des tailles d'origine des blocs précédents
+	uint32_t taille; //taille compressée
+	uint32_t taille_originale;
+	uint32_t table; //bloc BLOC_TABLE dont la table sert à décoder ce bloc (lui-même pour un bloc BLOC_TABLE), UINT32_MAX s'il n'en a pas besoin
+} bloc_index;
+
+//structure partagée entre les threads de décompression : chaque thread prend le prochain bloc,
+//le décode directement à sa position dans dst, ou le passe à ecrire avec sa position
+typedef struct {
+	const uint8_t *src;
+	const bloc_index *blocs;
+	uint32_t nb_blocs;
+	uint32_t suivant; //prochain bloc à décoder
+	uint8_t *dst;
+	huff_ecrire_a ecrire;
+	void *ctx;
+	const huff_options *o;
+	int erreur;
+	pthread_mutex_t verrou;
+} travail_decompression;
+
+//structure partagée entre les threads d'un lot : chaque thread prend le prochain membre, et compte ses caractères
+//pour entraîner la table commune, ou le compresse à la place qui lui est réservée dans dst
+typedef struct {
+	const huff_membre *membres;
+	uint32_t nb_membres;
+	uint32_t suivant; //prochain membre à traiter
+	uint8_t *dst;
+	size_t *positions; //début de la place réservée à chaque membre dans dst
+	size_t *tailles; //taille compressée de chaque membre
+	const huff_options *o;
+	huff_dictionnaire *a_entrainer; //non NULL pendant le comptage des caractères de la table commune
+	const huff_dictionnaire *dictionnaire; //dictionnaire écrit dans l'archive, NULL s'il n'y en a pas
+	int commun; //1 si dictionnaire est la table commune : les membres qu'elle code mal gardent leurs propres codes
+	int erreur;
+	pthread_mutex_t verrou;
+} travail_lot;
+
+//noyau qui ajoute les caractères d'une zone aux sous-histogrammes
+typedef void (*noyau_histogramme)(const uint8_t *p, size_t n, uint32_t sous[HISTO_SOUS_TABLES][256]);
+
+//structure d'un décompresseur en flux : un bloc est rassemblé à partir des morceaux reçus, puis décodé
+struct huff_decompresseur {
+	huff_options o;
+	huff_ecrire ecrire;
+	void *ctx;
+	uint8_t *bloc; //bloc en cours de réception, en tête compris
+	size_t capacite_bloc;
+	size_t taille; //taille du bloc en cours, connue une fois son en tête reçu
+	size_t recus;
+	uint8_t *tampon; //bloc décodé
+	size_t capacite_tampon;
+	table_courante tc;
+	uint8_t en_tete[TAILLE_EN_TETE_FICHIER];
+	size_t recus_en_tete;
+	uint64_t taille_annoncee; //taille d'origine lue dans l'en tête du fichier
+	uint64_t decodes; //nombre d'octets d'origine déjà décodés
+	int fin; //1 quand le marqueur de fin a été reçu, ou le bloc d'un message court
+	int message; //1 si les données sont un message court : un seul bloc après le magic
+	int erreur;
+};
+
+static void demarrer_chrono(chrono *t, const huff_stats *s);
+static void mesurer_phase(chrono *t, huff_stats *s, int phase);
+static void compter_caracteres(huff_stats *s, const uint64_t tab[256], const uint8_t longueurs[256], size_t taille);
+static void ajouter_stats(huff_stats *total, const huff_stats *s);
+static void initialiser_crc(void);
+static uint32_t crc32c(const uint8_t *p, size_t n);
+static void ecrire_en_tete_bloc(uint8_t *sortie, int type, const uint8_t *donnees, size_t taille, size_t taille_bloc);
+static noyau_histogramme choisir_histogramme(void);
+static void apparitions(const uint8_t *donnees, size_t taille, uint64_t tab[256]);
+static void trier_feuilles(noeud *f, int n);
+static void creer_arbre(const uint64_t *tab, int nb_symboles, arbre *a);
+static int longueurs_huffman(const arbre *a, uint8_t longueurs[256]);
+static void longueurs_limitees(const uint64_t *tab, size_t nb_symboles, int lg_max, uint8_t *longueurs);
+static void codes_huffman(const uint8_t *longueurs, int nb_symboles, code_huffman *codes);
+static size_t en_tete(uint8_t *sortie, const uint8_t longueurs[256]);
+static size_t encoder(const uint8_t *donnees, size_t taille, const code_huffman codes[256], uint8_t *sortie);
+static int nb_flux_bloc(const huff_options *o, size_t taille);
+static size_t encoder_flux(const uint8_t *donnees, size_t taille, const code_huffman codes[256], const code_huffman *const *contextes, int nb_flux, uint8_t *sortie);
+static int longueurs_bloc(const uint64_t *tab, size_t nb_symboles, int lg_max, uint8_t *longueurs);
+static uint64_t taille_codee(const uint64_t *tab, int nb_symboles, const uint8_t *longueurs);
+static uint8_t* ecrire_bloc(int type, const uint8_t *donnees, size_t taille, const uint8_t longueurs[256], int nb_flux, uint64_t taille_prevue, size_t *taille_sortie);
+static size_t coder_bloc(uint8_t *sortie, int type, const uint8_t *donnees, size_t taille, const uint8_t longueurs[256], code_huffman codes[256], int nb_flux);
+static void apparitions_contexte(const uint8_t *donnees, size_t taille, int nb_flux, histogramme_contexte *h);
+static void grouper_contextes(const histogramme_contexte *h, const uint8_t *ordre, int nb_actifs, int k, uint8_t groupe[256]);
+static uint64_t taille_modele(const histogramme_contexte *h, int lg_max, modele_contexte *m);
+static uint64_t modele_ordre_1(const histogramme_contexte *h, int lg_max, uint64_t surcout, modele_contexte *m);
+static size_t en_tete_contexte(uint8_t *sortie, const modele_contexte *m);
+static uint8_t* ecrire_bloc_contexte(const modele_contexte *m, const uint8_t *donnees, size_t taille, int nb_flux, uint64_t taille_prevue, size_t *taille_sortie);
+static void compter_caracteres_contexte(huff_stats *s, const histogramme_contexte *h, const modele_contexte *m, size_t taille);
+static void apparitions_plages(const uint8_t *donnees, size_t taille, uint64_t tab[NB_SYMBOLES_MAX]);
+static size_t encoder_plages(const uint8_t *donnees, size_t taille, const code_huffman codes[NB_SYMBOLES_MAX], uint8_t *sortie);
+static uint64_t taille_plages(const uint64_t tab[NB_SYMBOLES_MAX], int lg_max, uint8_t longueurs[NB_SYMBOLES_MAX]);
+static uint8_t* ecrire_bloc_plages(const uint8_t longueurs[NB_SYMBOLES_MAX], const uint8_t *donnees, size_t taille, uint64_t taille_prevue, size_t *taille_sortie);
+static void compter_caracteres_plages(huff_stats *s, const uint64_t tab[256], const uint64_t symboles[NB_SYMBOLES_MAX], const uint8_t longueurs[NB_SYMBOLES_MAX], size_t taille);
+static int bloc_incompressible(const uint8_t *donnees, size_t taille, int lg_max);
+static int choisir_codage(const uint8_t *precedente, int lg_max, const uint64_t tab[256], size_t taille, uint64_t surcout, int alternative, uint64_t taille_alternative, uint8_t longueurs[256], uint64_t *taille_prevue);
+static void compresser_bloc(huff_compresseur *c, uint64_t i, emplacement *b);
+static uint8_t* compresser_bloc_dictionnaire(const uint8_t *donnees, size_t taille, const huff_dictionnaire *d, int nb_flux, size_t *taille_sortie);
+static size_t coder_bloc_dictionnaire(uint8_t *sortie, const uint8_t *donnees, size_t taille, const huff_dictionnaire *d, int nb_flux);
+static int preparer_dictionnaire(huff_dictionnaire *d);
+static size_t ecrire_message(uint8_t *sortie, const uint8_t *donnees, size_t taille, const huff_options *o, uint64_t tab[256]);
+static size_t taille_bloc_flux(const uint8_t *en_tete);
+static uint16_t creer_noeud(arbre *a);
+static int remplace(arbre *a, code_huffman code, uint8_t valeur);
+static size_t lire_longueurs(const uint8_t *p, size_t taille, uint8_t longueurs[256]);
+static int code_prefixe(const uint8_t *longueurs, int nb_symboles);
+static uint32_t construire_niveau(table_decodage *t, const uint16_t *symboles, const uint32_t *bits, const uint8_t *longueurs, int nb, int decalage, uint8_t *largeur);
+static table_decodage* creer_table(const uint8_t *longueurs, int nb_symboles);
+static int remplir_table(table_decodage *t, const uint8_t *longueurs, int nb_symboles);
+static void free_table(table_decodage *t);
+static int decoder_suite(const table_decodage *t, lecteur_bits *l, uint8_t *s, uint8_t *s_fin);
+static int decoder_donnees(const table_decodage *t, const uint8_t *donnees, size_t taille, uint8_t *sortie, size_t n);
+static int ouvrir_4_flux(const uint8_t *donnees, size_t taille, uint8_t *sortie, size_t taille_originale, size_t n, lecteur_bits l[4], uint8_t *s[4], uint8_t *s_fin[4]);
+static int decoder_4_flux(const table_decodage *t, const arbre *a, const uint8_t *donnees, size_t taille, uint8_t *sortie, size_t taille_originale, size_t n);
+static int decoder_suite_contexte(const tables_contexte *mc, lecteur_bits *l, uint8_t *s, uint8_t *s_fin, uint8_t precedent);
+static int decoder_contexte(const tables_contexte *mc, int quatre_flux, const uint8_t *donnees, size_t taille, uint8_t *sortie, size_t taille_originale, size_t n);
+static int charger_contexte(const uint8_t *p, size_t taille, tables_contexte *mc, size_t *lus);
+static void free_tables_contexte(tables_contexte *mc);
+static int decoder_plages(const table_decodage *t, const uint8_t *donnees, size_t taille, uint8_t *sortie, size_t n);
+static int charger_plages(const uint8_t *p, size_t taille, table_decodage **table, size_t *lus);
+static int decoder_donnees_arbre(const arbre *a, const uint8_t *donnees, size_t taille, uint8_t *sortie, size_t n);
+static int charger_table(const uint8_t *bloc, size_t taille, table_courante *tc, size_t *lus);
+static void free_table_courante(table_courante *tc);
+static int decoder_bloc(const uint8_t *bloc, size_t taille, uint8_t *sortie, size_t taille_originale, size_t n, const huff_options *o, table_courante *tc, huff_stats *st);
+static int verifier_bloc(const uint8_t *bloc, const uint8_t *sortie, size_t taille_originale, size_t n);
+static int decoder_bloc_index(const uint8_t *src, const bloc_index *blocs, uint32_t i, uint8_t *sortie, size_t n, const huff_options *o, table_courante *tc, huff_stats *st);
+static int options_valides(const huff_options *o);
+static void* thread_compression(void *arg);
+static void publier(huff_compresseur *c, emplacement *b, const uint8_t *donnees, size_t taille);
+static int ecrire_compresseur(huff_compresseur *c, const void *p, size_t n);
+static int ecrire_en_tete_fichier(huff_compresseur *c);
+static void ecrire_plus_ancien(huff_compresseur *c);
+static void arreter_threads(huff_compresseur *c);
+static int lire_index(const uint8_t *src, size_t taille, bloc_index **blocs, uint32_t *nb_blocs, uint64_t *taille_sortie);
+static void* thread_decompression(void *arg);
+static int decompresser_blocs(const uint8_t *src, size_t taille, uint8_t *dst, size_t taille_dst, huff_ecrire_a ecrire, void *ctx, const huff_options *o);
+static size_t taille_bloc_flux(const uint8_t *en_tete);
+static void decoder_bloc_flux(huff_decompresseur *d, const uint8_t *bloc, size_t taille);
+
+//fonction pour remplir les options avec les valeurs par défaut
+void huff_options_defaut(huff_options *o)
+{
+	o->taille_bloc = HUFF_TAILLE_BLOC_DEFAUT;
+	o->lg_max = HUFF_LONGUEUR_DEFAUT;
+	o->nb_threads = 1;
+	o->arbre = 0;
+	o->dictionnaire = NULL;
+	o->nb_flux = 4;
+	o->stats = NULL;
+	o->ordre = 0;
+	o->plages = 0;
+	o->table_commune = 0;
+}
+
+//fonction qui renvoie le message d'erreur correspondant à un code de retour
+const char* huff_erreur(int code)
+{
+	switch (code)
+	{
+		case HUFF_OK:
+			return "pas d'erreur";
+		case HUFF_ERREUR_DONNEES:
+			return "données compressées corrompues ou tronquées";
+		case HUFF_ERREUR_PLACE:
+			return "tampon de sortie trop petit";
+		case HUFF_ERREUR_PARAMETRE:
+			return "paramètre invalide (taille de bloc, nombre de threads, longueur maximale des codes, nombre de flux, ordre, plages ou dictionnaire)";
+		case HUFF_ERREUR_ECRITURE:
+			return "erreur d'écriture";
+		case HUFF_ERREUR_DICTIONNAIRE:
+			return "les données ont été compressées avec un autre dictionnaire";
+		case HUFF_ERREUR_VERSION:
+			return "version du format non supportée";
+		case HUFF_ERREUR_CONTEXTE:
+			return "les données demandent plus de place que n'en a le contexte (modèle d'ordre 1, plages ou codes de plus de 15 bits)";
+		case HUFF_ERREUR_MEMOIRE:
+			return "mémoire insuffisante";
+		default:
+			return "erreur inconnue";
+	}
+}
+
+//fonction pour vérifier les options
+static int options_valides(const huff_options *o)
+{
+	return o->taille_bloc > 0 && o->taille_bloc <= HUFF_TAILLE_BLOC_MAX && o->lg_max >= 1 && o->lg_max <= LONGUEUR_MAX && o->nb_threads >= 1
+		&& (o->nb_flux == 1 || o->nb_flux == 4) && (o->ordre == 0 || o->ordre == 1) && (o->plages == 0 || o->plages == 1)
+		&& (o->table_commune == 0 || o->table_commune == 1) && (o->dictionnaire == NULL || o->dictionnaire->table != NULL);
+}
+
+//verrou des mesures : plusieurs threads, ou plusieurs compresseurs avec les mêmes options, peuvent ajouter leurs mesures au même huff_stats
+static pthread_mutex_t verrou_stats = PTHREAD_MUTEX_INITIALIZER;
+
+//fonction qui renvoie le temps d'une horloge en nanosecondes
+static uint64_t horloge(clockid_t id)
+{
+	struct timespec t;
+	clock_gettime(id, &t);
+	return (uint64_t)t.tv_sec * 1000000000u + t.tv_nsec;
+}
+
+//fonction pour démarrer le chronomètre d'un thread, si les mesures sont demandées (s non NULL) ; sinon il est mis à zéro
+//pour ne jamais être lu sans valeur
+static void demarrer_chrono(chrono *t, const huff_stats *s)
+{
+	t->reel = s != NULL ? horloge(CLOCK_MONOTONIC) : 0;
+	t->cpu = s != NULL ? horloge(CLOCK_THREAD_CPUTIME_ID) : 0;
+}
+
+//fonction pour ajouter à une phase le temps écoulé depuis la dernière mesure, la phase suivante commence tout de suite
+static void mesurer_phase(chrono *t, huff_stats *s, int phase)
+{
+	if (s != NULL)
+	{
+		uint64_t reel = horloge(CLOCK_MONOTONIC);
+		uint64_t cpu = horloge(CLOCK_THREAD_CPUTIME_ID);
+		s->ns_reel[phase] += reel - t->reel;
+		s->ns_cpu[phase] += cpu - t->cpu;
+		t->reel = reel;
+		t->cpu = cpu;
+	}
+}
+
+//fonction pour compter les caractères d'un bloc codé avec les longueurs données : bits de leurs codes et entropie d'ordre 0
+static void compter_caracteres(huff_stats *s, const uint64_t tab[256], const uint8_t longueurs[256], size_t taille)
+{
+	s->caracteres += taille;
+	for (int i = 0; i < 256; i++)
+	{
+		if (tab[i] > 0)
+		{
+			s->bits += tab[i] * longueurs[i];
+			s->entropie += tab[i] * log2((double)taille / tab[i]);
+			if (longueurs[i] > s->lg_max)
+			{
+				s->lg_max = longueurs[i];
+			}
+		}
+	}
+}
+
+//fonction pour compter les caractères d'un bloc BLOC_CONTEXTE : bits des codes de leur groupe et entropie d'ordre 1 (sachant le contexte)
+static void compter_caracteres_contexte(huff_stats *s, const histogramme_contexte *h, const modele_contexte *m, size_t taille)
+{
+	s->caracteres += taille;
+	for (int c = 0; c < 256; c++)
+	{
+		const uint8_t *longueurs = m->longueurs[m->groupe[c]];
+		for (int j = 0; j < h->nb_symboles[c]; j++)
+		{
+			uint8_t i = h->symboles[c][j];
+			s->bits += (uint64_t)h->apparitions[c][i] * longueurs[i];
+			s->entropie += h->apparitions[c][i] * log2((double)h->total[c] / h->apparitions[c][i]);
+			if (longueurs[i] > s->lg_max)
+			{
+				s->lg_max = longueurs[i];
+			}
+		}
+	}
+}
+
+//fonction pour compter les caractères d'un bloc BLOC_PLAGES : bits des codes de ses symboles, comparés à l'entropie d'ordre 0 des caractères
+static void compter_caracteres_plages(huff_stats *s, const uint64_t tab[256], const uint64_t symboles[NB_SYMBOLES_MAX], const uint8_t longueurs[NB_SYMBOLES_MAX], size_t taille)
+{
+	s->caracteres += taille;
+	for (int i = 0; i < NB_SYMBOLES_MAX; i++)
+	{
+		s->bits += symboles[i] * longueurs[i];
+		if (longueurs[i] > s->lg_max)
+		{
+			s->lg_max = longueurs[i];
+		}
+	}
+	for (int i = 0; i < 256; i++)
+	{
+		if (tab[i] > 0)
+		{
+			s->entropie += tab[i] * log2((double)taille / tab[i]);
+		}
+	}
+}
+
+//fonction pour ajouter les mesures d'un thread ou d'un bloc au total demandé par l'appelant
+static void ajouter_stats(huff_stats *total, const huff_stats *s)
+{
+	pthread_mutex_lock(&verrou_stats);
+	for (int p = 0; p < HUFF_NB_PHASES; p++)
+	{
+		total->ns_reel[p] += s->ns_reel[p];
+		total->ns_cpu[p] += s->ns_cpu[p];
+	}
+	total->octets_entree += s->octets_entree;
+	total->octets_sortie += s->octets_sortie;
+	total->blocs += s->blocs;
+	total->caracteres += s->caracteres;
+	total->bits += s->bits;
+	total->entropie += s->entropie;
+	total->lg_max = s->lg_max > total->lg_max ? s->lg_max : total->lg_max;
+	total->ecritures += s->ecritures;
+	pthread_mutex_unlock(&verrou_stats);
+}
+
+//fonction pour écrire les mesures en JSON : temps de chaque phase en secondes, compteurs, et pour la compression
+//le nombre moyen de bits par caractère comparé à l'entropie
+int huff_stats_json(const huff_stats *s, char *dst, size_t taille)
+{
+	static const char *noms[HUFF_NB_PHASES] = {"histogramme", "arbre", "codage", "tables", "decodage", "ecriture"};
+	double caracteres = s->caracteres > 0 ? (double)s->caracteres : 1;
+	char phases[HUFF_NB_PHASES * 128]; //une entrée par phase, chacune tient largement dans 128 caractères
+	size_t t = 0;
+	for (int p = 0; p < HUFF_NB_PHASES; p++)
+	{
+		t += sprintf(phases + t, "%s\"%s\": {\"reel_s\": %.6f, \"cpu_s\": %.6f}", p > 0 ? ", " : "", noms[p], s->ns_reel[p] * 1e-9, s->ns_cpu[p] * 1e-9);
+	}
+	char entropie[128] = ""; //la décompression ne connaît pas l'entropie des données
+	if (s->entropie > 0)
+	{
+		sprintf(entropie, ", \"entropie_par_caractere\": %.4f, \"ecart_entropie\": %.4f", s->entropie / caracteres, (s->bits - s->entropie) / caracteres);
+	}
+	return snprintf(dst, taille, "{\"phases\": {%s}, \"octets_entree\": %llu, \"octets_sortie\": %llu, \"blocs\": %llu, \"caracteres\": %llu, "
+		"\"bits_par_caractere\": %.4f%s, \"lg_max\": %u, \"ecritures\": %llu}",
+		phases, (unsigned long long)s->octets_entree, (unsigned long long)s->octets_sortie, (unsigned long long)s->blocs,
+		(unsigned long long)s->caracteres, s->bits / caracteres, entropie, s->lg_max, (unsigned long long)s->ecritures);
+}
+
+//table du CRC32C pour un octet, remplie au premier calcul sans SSE4.2
+static uint32_t table_crc[256];
+static pthread_once_t table_crc_prete = PTHREAD_ONCE_INIT;
+
+//fonction pour remplir la table du CRC32C (polynôme de Castagnoli, en ordre réfléchi)
+static void initialiser_crc(void)
+{
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		uint32_t crc = i;
+		for (int k = 0; k < 8; k++)
+		{
+			crc = (crc >> 1) ^ (0x82F63B78u & -(crc & 1));
+		}
+		table_crc[i] = crc;
+	}
+}
+
+#ifdef CRC_SSE42
+//version SSE4.2 : l'instruction crc32 traite 8 octets à la fois
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(const uint8_t *p, size_t n)
+{
+	uint64_t crc = 0xFFFFFFFFu;
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		uint64_t v;
+		memcpy(&v, p + i, 8);
+		crc = _mm_crc32_u64(crc, v);
+	}
+	for (; i < n; i++)
+	{
+		crc = _mm_crc32_u8((uint32_t)crc, p[i]);
+	}
+	return ~(uint32_t)crc;
+}
+#endif
+
+//fonction qui renvoie le CRC32C de n octets
+static uint32_t crc32c(const uint8_t *p, size_t n)
+{
+#ifdef CRC_SSE42
+	if (__builtin_cpu_supports("sse4.2"))
+	{
+		return crc32c_sse42(p, n);
+	}
+#endif
+	pthread_once(&table_crc_prete, initialiser_crc);
+	uint32_t crc = 0xFFFFFFFFu;
+	for (size_t i = 0; i < n; i++)
+	{
+		crc = table_crc[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+//fonction qui ajoute les caractères d'un bloc aux sous-histogrammes
+//les octets consécutifs vont dans des sous-histogrammes différents : des octets répétés n'attendent pas l'incrément précédent
+static void histogramme_bloc(const uint8_t *p, size_t n, uint32_t sous[HISTO_SOUS_TABLES][256])
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		uint64_t v;
+		memcpy(&v, p + i, 8); //on lit 8 caractères d'un coup
+		sous[0][v & 0xff]++;
+		sous[1][(v >> 8) & 0xff]++;
+		sous[2][(v >> 16) & 0xff]++;
+		sous[3][(v >> 24) & 0xff]++;
+		sous[0][(v >> 32) & 0xff]++;
+		sous[1][(v >> 40) & 0xff]++;
+		sous[2][(v >> 48) & 0xff]++;
+		sous[3][v >> 56]++;
+	}
+	for (; i < n; i++)
+	{
+		sous[0][p[i]]++;
+	}
+}
+
+#ifdef HISTO_AVX2
+//version AVX2 : on compare 32 caractères au premier d'entre eux et une suite de 32 caractères identiques est comptée d'un coup.
+//Après une fenêtre sans plage, la suite est comptée par le noyau scalaire sur une zone qui grandit de 64 octets à chaque échec
+//jusqu'à HISTO_SAUT_MAX : sans plages, on ne compare plus qu'une fenêtre par Ko et le noyau va aussi vite que le scalaire
+__attribute__((target("avx2")))
+static void histogramme_bloc_avx2(const uint8_t *p, size_t n, uint32_t sous[HISTO_SOUS_TABLES][256])
+{
+	size_t i = 0;
+	size_t saut = 0; //octets à compter en scalaire après le prochain échec
+	while (i + 32 <= n)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+		__m256i premier = _mm256_set1_epi8((char)p[i]);
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, premier)) == -1)
+		{
+			sous[0][p[i]] += 32;
+			i += 32;
+			saut = 0;
+		}
+		else
+		{
+			saut = saut < HISTO_SAUT_MAX ? saut + 64 : HISTO_SAUT_MAX;
+			size_t m = n - i < saut ? n - i : saut;
+			histogramme_bloc(p + i, m, sous);
+			i += m;
+		}
+	}
+	_mm256_zeroupper(); //sinon le code SSE qui suit (log2 du modèle d'ordre 1) paie la transition AVX-SSE à chaque instruction
+	histogramme_bloc(p + i, n - i, sous);
+}
+#endif
+
+//fonction qui renvoie le noyau de comptage des caractères, choisi à l'exécution selon le processeur
+static noyau_histogramme choisir_histogramme(void)
+{
+#ifdef HISTO_AVX2
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return histogramme_bloc_avx2;
+	}
+#endif
+	return histogramme_bloc;
+}
+
+//fonction pour compter le nombre d'apparitions de chaque caractère d'une zone en mémoire
+//les compteurs sont en 64 bits : une entrée de plus de 4 Go ne déborde pas
+static void apparitions(const uint8_t *donnees, size_t taille, uint64_t tab[256])
+{
+	for (int i = 0; i < 256; i++) 
+	{
+		tab[i] = 0; //on initialise tout le tableau à 0
+	}
+	if (taille < HISTO_PETIT) //les sous-histogrammes coûteraient plus à remettre à zéro et à fusionner qu'à compter
+	{
+		for (size_t i = 0; i < taille; i++)
+		{
+			tab[donnees[i]]++;
+		}
+		return;
+	}
+	
+	noyau_histogramme noyau = choisir_histogramme();
+	uint32_t sous[HISTO_SOUS_TABLES][256];
+	for (size_t debut = 0; debut < taille; debut += HISTO_BLOC) //on compte par blocs pour que les sous-histogrammes ne débordent pas
+	{
+		size_t n = taille - debut < HISTO_BLOC ? taille - debut : HISTO_BLOC;
+		memset(sous, 0, sizeof(sous));
+		noyau(donnees + debut, n, sous);
+		
+		for (int k = 0; k < HISTO_SOUS_TABLES; k++) //on fusionne les sous-histogrammes
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				tab[i] += sous[k][i]; //la frequence à l'indice i correspond au caractère dont le nombre ascii associé est i
+			}
+		}
+	}
+}
+
+//fonction pour trier les feuilles par poids croissant, sans allocation (le qsort de la glibc alloue au delà de 1 Ko et appelle
+//la comparaison par un pointeur) : tri par insertion de groupes de 16 feuilles, puis fusions deux à deux. Le tri est stable :
+//les feuilles arrivent dans l'ordre des caractères, les poids égaux restent donc triés par caractère.
+static void trier_feuilles(noeud *f, int n)
+{
+	const int groupe = 16;
+	for (int debut = 0; debut < n; debut += groupe)
+	{
+		int fin = debut + groupe < n ? debut + groupe : n;
+		for (int i = debut + 1; i < fin; i++)
+		{
+			noeud x = f[i];
+			int k = i;
+			while (k > debut && f[k - 1].poids > x.poids)
+			{
+				f[k] = f[k - 1];
+				k--;
+			}
+			f[k] = x;
+		}
+	}
+	
+	noeud fusion[NB_SYMBOLES_MAX];
+	for (int largeur = groupe; largeur < n; largeur *= 2)
+	{
+		for (int debut = 0; debut + largeur < n; debut += 2 * largeur)
+		{
+			int milieu = debut + largeur;
+			int fin = milieu + largeur < n ? milieu + largeur : n;
+			int i = debut, j = milieu, k = 0;
+			while (i < milieu && j < fin)
+			{
+				fusion[k++] = f[j].poids < f[i].poids ? f[j++] : f[i++]; //à poids égal, la feuille de gauche d'abord
+			}
+			while (i < milieu)
+			{
+				fusion[k++] = f[i++];
+			}
+			memcpy(f + debut, fusion, k * sizeof(noeud)); //les feuilles de droite qui restent sont déjà à leur place
+		}
+	}
+}
+
+//fonction qui construit l'arbre de Huffman avec la méthode des deux files :
+//la première file contient les feuilles triées, la seconde les noeuds fusionnés, qui sont créés par poids croissant.
+//Le plus petit noeud est donc toujours en tête de l'une des deux files, sans recherche ni insertion triée.
+static void creer_arbre(const uint64_t *tab, int nb_symboles, arbre *a)
+{
+	uint16_t n = 0; //nombre de caractères présents dans le fichier
+	for (uint16_t i = 0; i < nb_symboles; i++)
+	{
+		//chaque symbole est écrit, mais seuls les présents sont gardés : pas de saut à prédire
+		a->noeuds[n].poids = tab[i];
+		a->noeuds[n].lettre = i;
+		a->noeuds[n].gauche = AUCUN;
+		a->noeuds[n].droite = AUCUN;
+		n += tab[i] > 0;
+	}
+	trier_feuilles(a->noeuds, n);
+	a->nb_feuilles = n;
+	a->nb_noeuds = n;
+	
+	if (n == 0)
+	{
+		a->racine = AUCUN;
+		return;
+	}
+	
+	uint16_t f = 0; //tête de la file des feuilles (indices 0 à n-1)
+	uint16_t g = n; //tête de la file des noeuds fusionnés (indices n à nb_noeuds-1)
+	while (a->nb_noeuds - f - (g - n) > 1) //tant qu'il reste plus d'un noeud dans les deux files
+	{
+		uint16_t min[2];
+		for (int k = 0; k < 2; k++) //on prend deux fois le plus petit des deux noeuds de tête
+		{
+			if (g == a->nb_noeuds || (f < n && a->noeuds[f].poids <= a->noeuds[g].poids))
+			{
+				min[k] = f++;
+			}
+			else
+			{
+				min[k] = g++;
+			}
+		}
+		
+		noeud *fusion = &a->noeuds[a->nb_noeuds];
+		fusion->poids = a->noeuds[min[0]].poids + a->noeuds[min[1]].poids;
+		fusion->lettre = 0;
+		fusion->gauche = min[0];
+		fusion->droite = min[1];
+		a->nb_noeuds++;
+	}
+	
+	a->racine = a->nb_noeuds - 1; //lorsque toutes les fusions sont faites, le dernier noeud créé est la racine
+}
+
+//fonction pour calculer la longueur du code Huffman de chaque caractère, c'est-à-dire la profondeur de sa feuille
+//les enfants ont toujours un indice plus petit que leur parent : on parcourt le tableau depuis la racine en descendant
+//elle renvoie la longueur du code le plus long, qui peut dépasser LONGUEUR_MAX
+static int longueurs_huffman(const arbre *a, uint8_t longueurs[256])
+{
+	if (a->racine == AUCUN)
+	{
+		return 0;
+	}
+	
+	uint8_t profondeur[NB_NOEUDS_MAX]; //au plus NB_SYMBOLES_MAX - 1
+	profondeur[a->racine] = 0;
+	int lg_max = 0;
+	
+	for (int i = a->racine; i >= 0; i--)
+	{
+		const noeud *n = &a->noeuds[i];
+		if (n->gauche == AUCUN) //si on est arrivé à une feuille de l'arbre
+		{
+			longueurs[n->lettre] = profondeur[i];
+			if (profondeur[i] > lg_max)
+			{
+				lg_max = profondeur[i];
+			}
+			continue;
+		}
+		
+		profondeur[n->gauche] = profondeur[i] + 1;
+		profondeur[n->droite] = profondeur[i] + 1;
+	}
+	return lg_max;
+}
+
+//fonction pour calculer les longueurs de codes optimales parmi celles qui ne dépassent pas lg_max (algorithme package-merge)
+//Au niveau 0 la liste ne contient que les feuilles triées. Chaque niveau suivant fusionne les feuilles avec les paquets
+//formés par les paires consécutives du niveau précédent. On garde les 2n-2 premiers éléments du dernier niveau : la longueur
+//d'un caractère est le nombre de fois où sa feuille est gardée, en descendant les paquets gardés niveau par niveau.
+static void longueurs_limitees(const uint64_t *tab, size_t nb_symboles, int lg_max, uint8_t *longueurs)
+{
+	uint16_t feuilles[NB_SYMBOLES_MAX]; //caractères présents, triés par poids croissant
+	int n = 0;
+	for (size_t i = 0; i < nb_symboles; i++)
+	{
+		if (tab[i] == 0)
+		{
+			continue;
+		}
+		int k = n++;
+		while (k > 0 && tab[feuilles[k - 1]] > tab[i]) //tri par insertion, stable pour les poids égaux
+		{
+			feuilles[k] = feuilles[k - 1];
+			k--;
+		}
+		feuilles[k] = i;
+	}
+	
+	memset(longueurs, 0, nb_symboles);
+	if (n < 2)
+	{
+		return;
+	}
+	
+	uint64_t poids[2][2 * NB_SYMBOLES_MAX]; //poids des éléments du niveau précédent et du niveau courant
+	uint8_t paquet[LONGUEUR_MAX][2 * NB_SYMBOLES_MAX]; //1 si l'élément est un paquet, 0 si c'est une feuille
+	int taille[LONGUEUR_MAX];
+	
+	for (int i = 0; i < n; i++)
+	{
+		poids[0][i] = tab[feuilles[i]];
+		paquet[0][i] = 0;
+	}
+	taille[0] = n;
+	
+	for (int l = 1; l < lg_max; l++)
+	{
+		const uint64_t *prec = poids[(l - 1) & 1];
+		uint64_t *cour = poids[l & 1];
+		int nb_paquets = taille[l - 1] / 2;
+		int f = 0, p = 0, t = 0;
+		while (f < n || p < nb_paquets) //fusion de deux listes triées, les feuilles passent d'abord à poids égal
+		{
+			uint64_t poids_paquet = p < nb_paquets ? prec[2 * p] + prec[2 * p + 1] : UINT64_MAX;
+			if (f < n && tab[feuilles[f]] <= poids_paquet)
+			{
+				cour[t] = tab[feuilles[f++]];
+				paquet[l][t++] = 0;
+			}
+			else
+			{
+				cour[t] = poids_paquet;
+				paquet[l][t++] = 1;
+				p++;
+			}
+		}
+		taille[l] = t;
+	}
+	
+	int m = 2 * n - 2; //nombre d'éléments gardés au niveau courant
+	for (int l = lg_max - 1; l >= 0; l--)
+	{
+		int j = 0; //les feuilles gardées sont les j premières feuilles triées
+		for (int x = 0; x < m; x++)
+		{
+			j += paquet[l][x] == 0;
+		}
+		for (int i = 0; i < j; i++)
+		{
+			longueurs[feuilles[i]]++;
+		}
+		m = 2 * (m - j); //chaque paquet gardé garde les deux éléments du niveau inférieur qui le forment
+	}
+}
+
+//fonction pour générer les codes Huffman canoniques à partir des longueurs :
+//les codes d'une même longueur se suivent dans l'ordre des caractères, et le premier code d'une longueur
+//suit le dernier code de la longueur précédente (décalé d'un bit)
+static void codes_huffman(const uint8_t *longueurs, int nb_symboles, code_huffman *codes)
+{
+	uint32_t nb_par_longueur[LONGUEUR_MAX + 1] = {0};
+	for (int i = 0; i < nb_symboles; i++)
+	{
+		if (longueurs[i] > 0) //les symboles absents incrémenteraient tous le même compteur, chaque incrément attendant le précédent
+		{
+			nb_par_longueur[longueurs[i]]++;
+		}
+	}
+	
+	uint32_t suivant[LONGUEUR_MAX + 1]; //prochain code à attribuer pour chaque longueur
+	uint32_t code = 0;
+	for (int l = 1; l <= LONGUEUR_MAX; l++)
+	{
+		code = (code + nb_par_longueur[l - 1]) << 1;
+		suivant[l] = code;
+	}
+	
+	for (int i = 0; i < nb_symboles; i++)
+	{
+		codes[i].longueur = longueurs[i];
+		codes[i].bits = longueurs[i] > 0 ? suivant[longueurs[i]]++ : 0;
+	}
+}
+
+//fonction pour écrire l'en tete des longueurs d'un bloc : seules les longueurs des codes sont écrites,
+//dans le format le plus court parmi les quartets, les octets et la liste éparse
+static size_t en_tete(uint8_t *sortie, const uint8_t longueurs[256])
+{
+    	size_t decalage = 0;
+
+    	uint16_t nb_codes = 0; //on va calculer le nombre de codes huffman, donc le nombre de caractères présents dans le fichier 
+    	uint8_t lg_max = 0;
+    	for (uint16_t i = 0; i < 256; i++) 
+    	{
+        	if (longueurs[i] > 0) 
+        	{
+            		nb_codes++;
+        	}
+        	if (longueurs[i] > lg_max)
+        	{
+        		lg_max = longueurs[i];
+        	}
+    	}
+    	
+    	uint32_t taille_eparse = nb_codes < 256 ? 1 + 2 * (uint32_t)nb_codes : UINT32_MAX;
+    	uint32_t taille_quartets = lg_max <= 15 ? 128 : UINT32_MAX;
+    	
+    	if (taille_eparse <= taille_quartets && taille_eparse <= 256)
+    	{
+    		sortie[decalage++] = EN_TETE_EPARSE;
+    		sortie[decalage++] = (uint8_t)nb_codes;
+    		for (uint16_t i = 0; i < 256; i++)
+    		{
+    			if (longueurs[i] > 0)
+    			{
+    				sortie[decalage++] = (uint8_t)i; //le code ascii du caractère puis la longueur de son code
+    				sortie[decalage++] = longueurs[i];
+    			}
+    		}
+    	}
+    	else if (taille_quartets <= 256)
+    	{
+    		sortie[decalage++] = EN_TETE_QUARTETS;
+    		for (uint16_t i = 0; i < 256; i += 2)
+    		{
+    			sortie[decalage++] = (uint8_t)((longueurs[i] << 4) | longueurs[i + 1]);
+    		}
+    	}
+    	else
+    	{
+    		sortie[decalage++] = EN_TETE_OCTETS;
+    		memcpy(sortie + decalage, longueurs, 256);
+    		decalage += 256;
+    	}
+
+    	return decalage;
+}
+
+//fonction pour lire 8 octets en commençant par l'octet de poids fort
+static inline uint64_t lire_64(const uint8_t *p)
+{
+	uint64_t v = 0;
+	for (int k = 0; k < 8; k++)
+	{
+		v = (v << 8) | p[k];
+	}
+	return v;
+}
+
+//fonction pour écrire 8 octets dans le tampon en commençant par l'octet de poids fort
+static inline void ecrire_64(uint8_t *p, uint64_t v)
+{
+	for (int k = 0; k < 8; k++)
+	{
+		p[k] = (uint8_t)(v >> (56 - 8 * k));
+	}
+}
+
+//fonctions pour écrire les entiers du format en petit-boutiste
+static inline void ecrire_u32(uint8_t *p, uint32_t v)
+{
+	for (int k = 0; k < 4; k++)
+	{
+		p[k] = (uint8_t)(v >> (8 * k));
+	}
+}
+
+static inline void ecrire_u64(uint8_t *p, uint64_t v)
+{
+	for (int k = 0; k < 8; k++)
+	{
+		p[k] = (uint8_t)(v >> (8 * k));
+	}
+}
+
+//fonction pour ajouter un code à l'accumulateur (le dernier code est sur les bits de poids faible, toujours moins de 64 bits) :
+//quand il est plein, on le complète avec le début du code et on écrit les 8 octets dans sortie
+static inline void ajouter_code(code_huffman code, uint64_t *accumulateur, int *nb_bits, uint8_t *sortie, size_t *t)
+{
+        if (*nb_bits + code.longueur < 64)
+        {
+        	*accumulateur = (*accumulateur << code.longueur) | code.bits;
+        	*nb_bits += code.longueur;
+        }
+        else
+        {
+        	int r = 64 - *nb_bits;
+        	ecrire_64(sortie + *t, (*accumulateur << r) | (code.bits >> (code.longueur - r)));
+        	*t += 8;
+        	*nb_bits = code.longueur - r;
+        	*accumulateur = code.bits & (((uint64_t)1 << *nb_bits) - 1);
+        }
+}
+
+//fonction pour écrire les bits qui restent dans l'accumulateur, complétés avec des zéros à droite, elle renvoie la taille finale
+static inline size_t vider_accumulateur(uint64_t accumulateur, int nb_bits, uint8_t *sortie, size_t t)
+{
+    	if (nb_bits > 0)
+    	{
+    		uint64_t reste = accumulateur << (64 - nb_bits);
+    		for (int k = 0; k < (nb_bits + 7) / 8; k++)
+    		{
+    			sortie[t++] = (uint8_t)(reste >> (56 - 8 * k));
+    		}
+    	}
+    	return t;
+}
+
+//fonction qui code les caractères d'une zone en mémoire et renvoie le nombre d'octets écrits dans sortie
+//sortie doit pouvoir contenir (taille * longueur maximale + 7) / 8 octets plus 8 octets de marge
+static size_t encoder(const uint8_t *donnees, size_t taille, const code_huffman codes[256], uint8_t *sortie)
+{
+    	size_t t = 0; //nombre d'octets écrits dans la sortie
+    	uint64_t accumulateur = 0;
+    	int nb_bits = 0; //nombre de bits actuellement stockés dans l'accumulateur
+
+    	for (size_t i = 0; i < taille; i++)
+    	{
+        	ajouter_code(codes[donnees[i]], &accumulateur, &nb_bits, sortie, &t); //on récupère le code Huffman du caractère dans le tableau codes
+	}
+    	return vider_accumulateur(accumulateur, nb_bits, sortie, t);
+}
+
+//fonction qui code les caractères d'une zone en mémoire avec les codes de leur contexte : contextes[c] donne les codes à utiliser
+//après le caractère c. Le premier caractère a le contexte 0. Même sortie que encoder.
+static size_t encoder_contexte(const uint8_t *donnees, size_t taille, const code_huffman *const contextes[256], uint8_t *sortie)
+{
+    	size_t t = 0;
+    	uint64_t accumulateur = 0;
+    	int nb_bits = 0;
+    	uint8_t precedent = 0;
+
+    	for (size_t i = 0; i < taille; i++)
+    	{
+        	ajouter_code(contextes[precedent][donnees[i]], &accumulateur, &nb_bits, sortie, &t);
+        	precedent = donnees[i];
+	}
+    	return vider_accumulateur(accumulateur, nb_bits, sortie, t);
+}
+
+//fonction qui renvoie le nombre de flux dans lesquels un bloc est codé
+static int nb_flux_bloc(const huff_options *o, size_t taille)
+{
+	return o->nb_flux == 4 && taille >= FLUX_BLOC_MIN ? 4 : 1;
+}
+
+//fonction pour coder un bloc en nb_flux flux de bits : avec 4 flux, le bloc est coupé en 4 quarts codés chacun dans son propre flux,
+//précédés de la table de saut qui permet au décodeur de trouver le début de chaque flux. Elle renvoie la taille écrite.
+//Si contextes n'est pas NULL, les caractères sont codés avec les codes de leur contexte, et chaque flux commence au contexte 0.
+static size_t encoder_flux(const uint8_t *donnees, size_t taille, const code_huffman codes[256], const code_huffman *const *contextes, int nb_flux, uint8_t *sortie)
+{
+	if (nb_flux == 1)
+	{
+		return contextes != NULL ? encoder_contexte(donnees, taille, contextes, sortie) : encoder(donnees, taille, codes, sortie);
+	}
+	
+	size_t quart = (taille + 3) / 4;
+	size_t t = TAILLE_TABLE_SAUT;
+	for (int k = 0; k < 4; k++)
+	{
+		size_t debut = k * quart < taille ? k * quart : taille;
+		size_t n = taille - debut < quart ? taille - debut : quart;
+		size_t taille_flux = contextes != NULL ? encoder_contexte(donnees + debut, n, contextes, sortie + t) //la marge écrite par encoder est recouverte par le flux suivant
+			: encoder(donnees + debut, n, codes, sortie + t);
+		if (k < 3)
+		{
+			ecrire_u32(sortie + 4 * k, (uint32_t)taille_flux);
+		}
+		t += taille_flux;
+	}
+	return t;
+}
+
+//fonction pour calculer les longueurs des codes des nb_symboles symboles d'un bloc à partir de leurs apparitions
+//elle renvoie -1 si lg_max est trop petit pour le nombre de caractères différents du bloc
+static int longueurs_bloc(const uint64_t *tab, size_t nb_symboles, int lg_max, uint8_t *longueurs)
+{
+    	int nb_caracteres = 0;
+    	for (size_t i = 0; i < nb_symboles; i++)
+    	{
+    		nb_caracteres += tab[i] > 0;
+    	}
+    	if (((uint64_t)1 << lg_max) < (uint64_t)nb_caracteres)
+    	{
+        	return -1; //les caractères différents ne tiennent pas dans des codes de lg_max bits
+    	}
+    
+    	arbre arb; //Création de l'arbre de Huffman, tous ses noeuds sont dans un seul tableau
+    	creer_arbre(tab, nb_symboles, &arb);
+    
+    	memset(longueurs, 0, nb_symboles); //seules les longueurs des codes sont tirées de l'arbre
+    	int profondeur = longueurs_huffman(&arb, longueurs);
+    	if (profondeur > lg_max)
+    	{
+    		longueurs_limitees(tab, nb_symboles, lg_max, longueurs); //l'arbre est trop profond, on limite la longueur des codes
+    	}
+    	else if (profondeur == 0 && nb_caracteres == 1) //l'arbre n'est qu'une feuille : on donne au caractère un code d'un bit
+    	{
+    		longueurs[arb.noeuds[arb.racine].lettre] = 1;
+    	}
+    	return 0;
+}
+
+//fonction qui renvoie la taille en octets des données d'un bloc codées avec les longueurs données,
+//ou UINT64_MAX si un caractère présent dans le bloc n'a pas de code
+static uint64_t taille_codee(const uint64_t *tab, int nb_symboles, const uint8_t *longueurs)
+{
+	uint64_t bits = 0;
+	for (int i = 0; i < nb_symboles; i++)
+	{
+		if (tab[i] == 0)
+		{
+			continue;
+		}
+		if (longueurs[i] == 0)
+		{
+			return UINT64_MAX;
+		}
+		bits += tab[i] * longueurs[i];
+	}
+	return (bits + 7) / 8;
+}
+
+//fonction pour écrire un bloc dans un tampon alloué avec coder_bloc, elle renvoie NULL si l'allocation échoue
+static uint8_t* ecrire_bloc(int type, const uint8_t *donnees, size_t taille, const uint8_t longueurs[256], int nb_flux, uint64_t taille_prevue, size_t *taille_sortie)
+{
+    	uint8_t *sortie = malloc(TAILLE_EN_TETE_BLOC + EN_TETE_TAILLE_MAX + FLUX_SURCOUT + taille_prevue + 8); //8 octets de marge pour encoder
+    	if (sortie == NULL)
+    	{
+    		return NULL;
+    	}
+    	code_huffman codes[256]; //tableau où on va stocker tous nos codes canoniques
+    	*taille_sortie = coder_bloc(sortie, type, donnees, taille, longueurs, codes, nb_flux);
+    	return sortie;
+}
+
+//fonction pour écrire un bloc dans sortie, qui doit avoir sa place plus 8 octets de marge : en tête du bloc, puis selon le type l'en tête
+//des longueurs et les données codées (BLOC_TABLE), les données codées avec la table précédente (BLOC_REUTILISE), les données telles
+//quelles (BLOC_BRUT) ou le caractère répété (BLOC_CONSTANT). Les données codées sont écrites en nb_flux flux, avec les codes canoniques
+//calculés dans codes d'après longueurs. Elle renvoie la taille du bloc.
+static size_t coder_bloc(uint8_t *sortie, int type, const uint8_t *donnees, size_t taille, const uint8_t longueurs[256], code_huffman codes[256], int nb_flux)
+{
+    	size_t t = TAILLE_EN_TETE_BLOC;
+    	if (type == BLOC_BRUT)
+    	{
+    		memcpy(sortie + t, donnees, taille);
+    		t += taille;
+    	}
+    	else if (type == BLOC_CONSTANT)
+    	{
+    		sortie[t++] = donnees[0];
+    	}
+    	else
+    	{
+    		if (type == BLOC_TABLE)
+    		{
+    			t += en_tete(sortie + t, longueurs);
+    		}
+    		codes_huffman(longueurs, 256, codes);
+    		t += encoder_flux(donnees, taille, codes, NULL, nb_flux, sortie + t);
+    		if (nb_flux == 4)
+    		{
+    			type |= BLOC_4_FLUX;
+    		}
+    	}
+    	
+    	ecrire_en_tete_bloc(sortie, type, donnees, taille, t);
+    	return t;
+}
+
+//fonction pour compter les apparitions de chaque caractère après chaque contexte dans un bloc codé en nb_flux flux :
+//chaque flux commence au contexte 0, comme dans encoder_contexte
+static void apparitions_contexte(const uint8_t *donnees, size_t taille, int nb_flux, histogramme_contexte *h)
+{
+	memset(h->apparitions, 0, sizeof(h->apparitions));
+	size_t quart = nb_flux == 4 ? (taille + 3) / 4 : taille;
+	for (size_t debut = 0; debut < taille; debut += quart)
+	{
+		size_t fin = taille - debut < quart ? taille : debut + quart;
+		uint8_t precedent = 0;
+		for (size_t i = debut; i < fin; i++)
+		{
+			h->apparitions[precedent][donnees[i]]++;
+			precedent = donnees[i];
+		}
+	}
+	
+	for (int c = 0; c < 256; c++)
+	{
+		h->total[c] = 0;
+		h->nb_symboles[c] = 0;
+		for (int s = 0; s < 256; s++)
+		{
+			if (h->apparitions[c][s] > 0)
+			{
+				h->total[c] += h->apparitions[c][s];
+				h->symboles[c][h->nb_symboles[c]++] = (uint8_t)s;
+			}
+		}
+	}
+}
+
+//fonction pour répartir les contextes présents en k groupes dont les caractères suivants se ressemblent : on part des k contextes
+//les plus fréquents (ordre), puis chaque contexte rejoint le groupe dont les codes lui coûteraient le moins de bits, estimés par
+//-log2 des fréquences du groupe lissées pour que les caractères absents aient un coût fini, jusqu'à ce que plus aucun ne change de groupe
+static void grouper_contextes(const histogramme_contexte *h, const uint8_t *ordre, int nb_actifs, int k, uint8_t groupe[256])
+{
+	uint64_t groupes[NB_GROUPES_MAX][256];
+	double cout[NB_GROUPES_MAX][256];
+	uint8_t presents[256]; //caractères présents dans le bloc, seuls leurs coûts servent
+	int nb_presents = 0;
+	for (int s = 0; s < 256; s++)
+	{
+		for (int i = 0; i < nb_actifs; i++)
+		{
+			if (h->apparitions[ordre[i]][s] > 0)
+			{
+				presents[nb_presents++] = (uint8_t)s;
+				break;
+			}
+		}
+	}
+	memset(groupe, 0, 256);
+	for (int g = 0; g < k; g++)
+	{
+		groupe[ordre[g]] = (uint8_t)g;
+		for (int s = 0; s < 256; s++)
+		{
+			groupes[g][s] = h->apparitions[ordre[g]][s];
+		}
+	}
+	
+	for (int iteration = 0; iteration < ITERATIONS_GROUPES; iteration++)
+	{
+		for (int g = 0; g < k; g++)
+		{
+			uint64_t total = 0;
+			for (int s = 0; s < 256; s++)
+			{
+				total += groupes[g][s];
+			}
+			double log_total = log2(total + 128.0);
+			for (int j = 0; j < nb_presents; j++)
+			{
+				cout[g][presents[j]] = log_total - log2(groupes[g][presents[j]] + 0.5);
+			}
+		}
+		
+		int changements = 0;
+		uint64_t charge[NB_GROUPES_MAX] = {0}; //caractères déjà placés dans chaque groupe pendant cette passe
+		for (int i = 0; i < nb_actifs; i++)
+		{
+			int c = ordre[i];
+			int meilleur = 0;
+			double cout_meilleur = 0;
+			for (int g = 0; g < k; g++)
+			{
+				double bits = 0;
+				for (int j = 0; j < h->nb_symboles[c]; j++)
+				{
+					uint8_t s = h->symboles[c][j];
+					bits += h->apparitions[c][s] * cout[g][s];
+				}
+				//à coût égal (aucun caractère suivant en commun, comme dans une rampe), le groupe le moins chargé : sinon tous ces contextes
+				//iraient dans le groupe 0 et leurs caractères suivants, tous différents, y seraient codés comme à l'ordre 0
+				if (g == 0 || bits < cout_meilleur || (bits == cout_meilleur && charge[g] < charge[meilleur]))
+				{
+					meilleur = g;
+					cout_meilleur = bits;
+				}
+			}
+			charge[meilleur] += h->total[c];
+			changements += groupe[c] != meilleur;
+			groupe[c] = (uint8_t)meilleur;
+		}
+		if (changements == 0 && iteration > 0)
+		{
+			break;
+		}
+		
+		memset(groupes, 0, sizeof(groupes));
+		for (int i = 0; i < nb_actifs; i++)
+		{
+			int c = ordre[i];
+			for (int j = 0; j < h->nb_symboles[c]; j++)
+			{
+				uint8_t s = h->symboles[c][j];
+				groupes[groupe[c]][s] += h->apparitions[c][s];
+			}
+		}
+	}
+}
+
+//fonction pour calculer les longueurs des codes de chaque groupe d'un modèle dont m->groupe est rempli : les groupes vides sont retirés
+//et les contextes absents du bloc vont dans le groupe 0. Elle renvoie la taille exacte de l'en tête des groupes et des données codées,
+//ou UINT64_MAX si un groupe a trop de caractères différents pour lg_max
+static uint64_t taille_modele(const histogramme_contexte *h, int lg_max, modele_contexte *m)
+{
+	uint64_t groupes[NB_GROUPES_MAX][256] = {{0}};
+	int numero[NB_GROUPES_MAX]; //nouveau numéro de chaque groupe non vide
+	for (int g = 0; g < NB_GROUPES_MAX; g++)
+	{
+		numero[g] = -1;
+	}
+	m->nb_groupes = 0;
+	for (int c = 0; c < 256; c++)
+	{
+		if (h->total[c] == 0)
+		{
+			m->groupe[c] = 0;
+			continue;
+		}
+		if (numero[m->groupe[c]] < 0)
+		{
+			numero[m->groupe[c]] = m->nb_groupes++;
+		}
+		m->groupe[c] = (uint8_t)numero[m->groupe[c]];
+		for (int j = 0; j < h->nb_symboles[c]; j++)
+		{
+			uint8_t s = h->symboles[c][j];
+			groupes[m->groupe[c]][s] += h->apparitions[c][s];
+		}
+	}
+	
+	uint64_t bits = 0;
+	uint64_t t = 1 + 128;
+	uint8_t tampon[EN_TETE_TAILLE_MAX];
+	for (int g = 0; g < m->nb_groupes; g++)
+	{
+		if (longueurs_bloc(groupes[g], 256, lg_max, m->longueurs[g]) != 0)
+		{
+			return UINT64_MAX;
+		}
+		for (int s = 0; s < 256; s++)
+		{
+			bits += groupes[g][s] * m->longueurs[g][s];
+		}
+		t += en_tete(tampon, m->longueurs[g]);
+	}
+	return t + (bits + 7) / 8;
+}
+
+//fonction pour construire le modèle d'ordre 1 d'un bloc : on essaie 2, 4, 8 puis 16 groupes de contextes tant que le résultat,
+//en tête compris, diminue. Elle renvoie la taille des données du bloc avec ce modèle plus surcout, ou UINT64_MAX sans modèle possible.
+static uint64_t modele_ordre_1(const histogramme_contexte *h, int lg_max, uint64_t surcout, modele_contexte *m)
+{
+	uint8_t ordre[256]; //contextes présents, du plus fréquent au moins fréquent
+	int nb_actifs = 0;
+	for (int c = 0; c < 256; c++)
+	{
+		if (h->total[c] > 0)
+		{
+			int i = nb_actifs++;
+			while (i > 0 && h->total[ordre[i - 1]] < h->total[c])
+			{
+				ordre[i] = ordre[i - 1];
+				i--;
+			}
+			ordre[i] = (uint8_t)c;
+		}
+	}
+	
+	uint64_t meilleure = UINT64_MAX;
+	modele_contexte essai;
+	for (int k = 2; k <= NB_GROUPES_MAX && k <= nb_actifs; k *= 2)
+	{
+		grouper_contextes(h, ordre, nb_actifs, k, essai.groupe);
+		uint64_t t = taille_modele(h, lg_max, &essai);
+		if (t >= meilleure && meilleure != UINT64_MAX)
+		{
+			break; //plus de groupes ne gagnent plus assez pour payer leurs en têtes
+		}
+		meilleure = t;
+		*m = essai;
+	}
+	return meilleure == UINT64_MAX ? UINT64_MAX : meilleure + surcout;
+}
+
+//fonction pour écrire l'en tête d'un bloc BLOC_CONTEXTE : le nombre de groupes, le groupe de chaque contexte (deux par octet,
+//le contexte pair sur les bits de poids faible), puis l'en tête des longueurs de chaque groupe. Elle renvoie la taille écrite.
+static size_t en_tete_contexte(uint8_t *sortie, const modele_contexte *m)
+{
+	size_t t = 0;
+	sortie[t++] = (uint8_t)m->nb_groupes;
+	for (int c = 0; c < 256; c += 2)
+	{
+		sortie[t++] = (uint8_t)(m->groupe[c] | (m->groupe[c + 1] << 4));
+	}
+	for (int g = 0; g < m->nb_groupes; g++)
+	{
+		t += en_tete(sortie + t, m->longueurs[g]);
+	}
+	return t;
+}
+
+//fonction pour écrire un bloc BLOC_CONTEXTE dans un tampon alloué : en tête du bloc, en tête des groupes, puis les données codées
+//en nb_flux flux avec les codes du groupe du caractère précédent. Elle renvoie NULL si l'allocation échoue.
+static uint8_t* ecrire_bloc_contexte(const modele_contexte *m, const uint8_t *donnees, size_t taille, int nb_flux, uint64_t taille_prevue, size_t *taille_sortie)
+{
+    	uint8_t *sortie = malloc(TAILLE_EN_TETE_BLOC + EN_TETE_CONTEXTE_MAX + FLUX_SURCOUT + taille_prevue + 8); //8 octets de marge pour encoder
+    	if (sortie == NULL)
+    	{
+    		return NULL;
+    	}
+    	
+    	size_t t = TAILLE_EN_TETE_BLOC;
+    	t += en_tete_contexte(sortie + t, m);
+    	code_huffman codes[NB_GROUPES_MAX][256];
+    	const code_huffman *contextes[256];
+    	for (int g = 0; g < m->nb_groupes; g++)
+    	{
+    		codes_huffman(m->longueurs[g], 256, codes[g]);
+    	}
+    	for (int c = 0; c < 256; c++)
+    	{
+    		contextes[c] = codes[m->groupe[c]];
+    	}
+    	t += encoder_flux(donnees, taille, NULL, contextes, nb_flux, sortie + t);
+    	
+    	ecrire_en_tete_bloc(sortie, nb_flux == 4 ? BLOC_CONTEXTE | BLOC_4_FLUX : BLOC_CONTEXTE, donnees, taille, t);
+    	*taille_sortie = t;
+    	return sortie;
+}
+
+//fonction qui renvoie la fin de la plage qui commence à la position i : le premier caractère différent de donnees[i]
+static inline size_t fin_plage(const uint8_t *donnees, size_t i, size_t taille)
+{
+	uint8_t c = donnees[i];
+	uint64_t motif = 0x0101010101010101u * c; //8 fois le caractère, le même dans les deux ordres des octets
+	size_t j = i + 1;
+	if (j < taille && donnees[j] == c)
+	{
+		while (taille - j >= 8 && lire_64(donnees + j) == motif)
+		{
+			j += 8;
+		}
+		while (j < taille && donnees[j] == c)
+		{
+			j++;
+		}
+	}
+	return j;
+}
+
+//fonction pour compter les symboles d'un bloc codé par plages : chaque caractère différent du précédent est un symbole,
+//et les n répétitions qui le suivent forment une plage dont la longueur est écrite en base 2 bijective,
+//du chiffre de poids faible au chiffre de poids fort, avec SYMBOLE_PLAGE_A pour le chiffre 1 et SYMBOLE_PLAGE_B pour le chiffre 2
+static void apparitions_plages(const uint8_t *donnees, size_t taille, uint64_t tab[NB_SYMBOLES_MAX])
+{
+	memset(tab, 0, NB_SYMBOLES_MAX * sizeof(uint64_t));
+	size_t i = 0;
+	while (i < taille)
+	{
+		size_t j = fin_plage(donnees, i, taille);
+		tab[donnees[i]]++;
+		for (size_t n = j - i - 1; n > 0; n = (n - 1) / 2) //chiffre 1 si n est impair, 2 sinon
+		{
+			tab[n & 1 ? SYMBOLE_PLAGE_A : SYMBOLE_PLAGE_B]++;
+		}
+		i = j;
+	}
+}
+
+//fonction qui code les caractères et les plages d'une zone en mémoire comme apparitions_plages les compte, même sortie que encoder
+static size_t encoder_plages(const uint8_t *donnees, size_t taille, const code_huffman codes[NB_SYMBOLES_MAX], uint8_t *sortie)
+{
+    	size_t t = 0;
+    	uint64_t accumulateur = 0;
+    	int nb_bits = 0;
+	size_t i = 0;
+	while (i < taille)
+	{
+		size_t j = fin_plage(donnees, i, taille);
+        	ajouter_code(codes[donnees[i]], &accumulateur, &nb_bits, sortie, &t);
+		for (size_t n = j - i - 1; n > 0; n = (n - 1) / 2)
+		{
+        		ajouter_code(codes[n & 1 ? SYMBOLE_PLAGE_A : SYMBOLE_PLAGE_B], &accumulateur, &nb_bits, sortie, &t);
+		}
+		i = j;
+	}
+    	return vider_accumulateur(accumulateur, nb_bits, sortie, t);
+}
+
+//fonction pour calculer les longueurs des codes d'un bloc codé par plages à partir de ses symboles
+//elle renvoie la taille des données du bloc (en tête compris), ou UINT64_MAX si les symboles ne tiennent pas dans lg_max bits
+static uint64_t taille_plages(const uint64_t tab[NB_SYMBOLES_MAX], int lg_max, uint8_t longueurs[NB_SYMBOLES_MAX])
+{
+	if (longueurs_bloc(tab, NB_SYMBOLES_MAX, lg_max, longueurs) != 0)
+	{
+		return UINT64_MAX;
+	}
+	uint8_t tampon[EN_TETE_TAILLE_MAX];
+	return en_tete(tampon, longueurs) + 2 + taille_codee(tab, NB_SYMBOLES_MAX, longueurs);
+}
+
+//fonction pour écrire un bloc BLOC_PLAGES dans un tampon alloué : en tête du bloc, en tête des longueurs des caractères,
+//longueurs des codes de SYMBOLE_PLAGE_A et SYMBOLE_PLAGE_B, puis les symboles codés en un seul flux. Elle renvoie NULL si l'allocation échoue.
+static uint8_t* ecrire_bloc_plages(const uint8_t longueurs[NB_SYMBOLES_MAX], const uint8_t *donnees, size_t taille, uint64_t taille_prevue, size_t *taille_sortie)
+{
+    	uint8_t *sortie = malloc(TAILLE_EN_TETE_BLOC + taille_prevue + 8); //8 octets de marge pour encoder
+    	if (sortie == NULL)
+    	{
+    		return NULL;
+    	}
+    	
+    	size_t t = TAILLE_EN_TETE_BLOC;
+    	t += en_tete(sortie + t, longueurs);
+    	sortie[t++] = longueurs[SYMBOLE_PLAGE_A];
+    	sortie[t++] = longueurs[SYMBOLE_PLAGE_B];
+    	code_huffman codes[NB_SYMBOLES_MAX];
+    	codes_huffman(longueurs, NB_SYMBOLES_MAX, codes);
+    	t += encoder_plages(donnees, taille, codes, sortie + t);
+    	
+    	ecrire_en_tete_bloc(sortie, BLOC_PLAGES, donnees, taille, t);
+    	*taille_sortie = t;
+    	return sortie;
+}
+
+//fonction pour écrire l'en tête d'un bloc de taille_bloc octets : type, taille d'origine, taille du reste et CRC32C des données d'origine
+static void ecrire_en_tete_bloc(uint8_t *sortie, int type, const uint8_t *donnees, size_t taille, size_t taille_bloc)
+{
+    	sortie[0] = (uint8_t)type;
+    	ecrire_u32(sortie + 1, (uint32_t)taille);
+    	ecrire_u32(sortie + 5, (uint32_t)(taille_bloc - TAILLE_EN_TETE_BLOC));
+    	ecrire_u32(sortie + 9, crc32c(donnees, taille));
+}
+
+//fonction pour créer un noeud de l'arbre de Huffman, elle renvoie son indice
+static uint16_t creer_noeud(arbre *a)
+{
+	noeud *n = &a->noeuds[a->nb_noeuds];
+	n->poids = 0;
+	n->lettre = 0;
+	n->gauche = AUCUN;
+	n->droite = AUCUN;
+	return a->nb_noeuds++;
+}
+
+//fonction qui va insérer les codes huffman dans l'arbre créé en partant de la racine
+//elle renvoie -1 si les codes demandent plus de noeuds que l'arbre n'en contient
+static int remplace(arbre *a, code_huffman code, uint8_t valeur)
+{
+    	uint16_t n = a->racine;
+    	for (int i = code.longueur - 1; i >= 0; i--) //on lit les bits du code en partant du bit de poids fort
+    	{
+    		//si le bit est '0', on va vers le sous-arbre gauche, sinon vers le sous-arbre droit
+    		uint16_t *enfant = ((code.bits >> i) & 1) == 0 ? &a->noeuds[n].gauche : &a->noeuds[n].droite;
+    		if (*enfant == AUCUN)
+    		{
+    			if (a->nb_noeuds == NB_NOEUDS_MAX)
+    			{
+    				return -1;
+    			}
+    			*enfant = creer_noeud(a); //on crée un noeud si ce n'est pas déjà fait
+    		}
+    		n = *enfant;
+    	}
+    	a->noeuds[n].lettre = valeur; //on affecte le caractère à la feuille à la fin du chemin
+    	return 0;
+}
+
+//fonction pour lire l'en tête des longueurs d'un bloc
+//elle renvoie le nombre d'octets lus, ou 0 si l'en tête est tronqué ou incohérent
+static size_t lire_longueurs(const uint8_t *p, size_t taille, uint8_t longueurs[256])
+{
+    	if (taille < 1)
+    	{
+    		return 0;
+    	}
+    	uint8_t format = p[0];
+    	size_t lus = 1;
+    	
+    	memset(longueurs, 0, 256);
+    	if (format == EN_TETE_QUARTETS)
+    	{
+    		if (taille < lus + 128)
+    		{
+    			return 0;
+    		}
+    		for (int i = 0; i < 128; i++)
+    		{
+    			longueurs[2 * i] = p[lus + i] >> 4;
+    			longueurs[2 * i + 1] = p[lus + i] & 0x0f;
+    		}
+    		lus += 128;
+    	}
+    	else if (format == EN_TETE_OCTETS)
+    	{
+    		if (taille < lus + 256)
+    		{
+    			return 0;
+    		}
+    		memcpy(longueurs, p + lus, 256);
+    		lus += 256;
+    	}
+    	else if (format == EN_TETE_EPARSE)
+    	{
+    		if (taille < lus + 1 || taille < lus + 1 + 2 * (size_t)p[lus])
+    		{
+    			return 0;
+    		}
+    		int nb_codes = p[lus++];
+    		for (int i = 0; i < nb_codes; i++)
+    		{
+    			longueurs[p[lus]] = p[lus + 1]; //le code ascii du caractère puis la longueur de son code
+    			lus += 2;
+    		}
+    	}
+    	else
+    	{
+    		return 0;
+    	}
+    	
+    	return code_prefixe(longueurs, 256) ? lus : 0;
+}
+
+//fonction qui vérifie que les longueurs lues forment un code préfixe : la somme des 2^(32 - longueur) ne dépasse pas 2^32
+static int code_prefixe(const uint8_t *longueurs, int nb_symboles)
+{
+    	uint64_t kraft = 0;
+    	for (int i = 0; i < nb_symboles; i++)
+    	{
+    		if (longueurs[i] > LONGUEUR_MAX)
+    		{
+		    	return 0;
+    		}
+    		if (longueurs[i] > 0)
+    		{
+    			kraft += (uint64_t)1 << (LONGUEUR_MAX - longueurs[i]);
+    		}
+    	}
+    	return kraft <= ((uint64_t)1 << LONGUEUR_MAX);
+}
+
+//fonction qui construit un niveau de la table de décodage pour des codes partageant les mêmes decalage premiers bits
+//elle renvoie la position du niveau dans t->entrees et écrit dans largeur le nombre de bits qui l'indexent,
+//ou UINT32_MAX si t->entrees n'a pas pu être agrandi
+static uint32_t construire_niveau(table_decodage *t, const uint16_t *symboles, const uint32_t *bits, const uint8_t *longueurs, int nb, int decalage, uint8_t *largeur)
+{
+	int lg = 0; //le niveau est indexé par au plus TABLE_BITS bits, les codes plus longs vont dans des sous-tables
+	for (int i = 0; i < nb; i++)
+	{
+		if (longueurs[i] - decalage > lg)
+		{
+			lg = longueurs[i] - decalage;
+		}
+	}
+	if (lg > TABLE_BITS)
+	{
+		lg = TABLE_BITS;
+	}
+	*largeur = lg;
+	
+	uint32_t position = t->taille;
+	uint32_t nb_entrees = (uint32_t)1 << lg;
+	if (t->taille + nb_entrees > t->capacite)
+	{
+		while (t->taille + nb_entrees > t->capacite)
+		{
+			t->capacite *= 2;
+		}
+		entree_table *entrees = realloc(t->entrees, t->capacite * sizeof(entree_table));
+		if (entrees == NULL)
+		{
+			return UINT32_MAX; //t->entrees reste valide, la table est libérée par l'appelant
+		}
+		t->entrees = entrees;
+	}
+	memset(t->entrees + position, 0, nb_entrees * sizeof(entree_table)); //longueur 0 : entrée invalide
+	t->taille += nb_entrees;
+	
+	for (int i = 0; i < nb; i++)
+	{
+		int reste = longueurs[i] - decalage; //nombre de bits du code qui restent à lire à partir de ce niveau
+		uint32_t code = bits[i] & (uint32_t)(((uint64_t)1 << reste) - 1);
+		if (reste <= lg)
+		{
+			//le code se termine à ce niveau : toutes les entrées qui commencent par lui donnent le caractère
+			uint32_t debut = code << (lg - reste);
+			for (uint32_t k = 0; k < ((uint32_t)1 << (lg - reste)); k++)
+			{
+				t->entrees[position + debut + k].valeur = symboles[i];
+				t->entrees[position + debut + k].longueur = reste;
+			}
+		}
+		else
+		{
+			t->entrees[position + (code >> (reste - lg))].sous_bits = 1; //on marque l'entrée, la sous-table est construite ensuite
+		}
+	}
+	
+	uint16_t sous_symboles[NB_SYMBOLES_MAX];
+	uint32_t sous_bits[NB_SYMBOLES_MAX];
+	uint8_t sous_longueurs[NB_SYMBOLES_MAX];
+	for (uint32_t v = 0; v < nb_entrees; v++)
+	{
+		if (t->entrees[position + v].sous_bits == 0)
+		{
+			continue;
+		}
+		
+		int n = 0; //on regroupe les codes dont les lg bits de ce niveau valent v
+		for (int i = 0; i < nb; i++)
+		{
+			int reste = longueurs[i] - decalage;
+			if (reste > lg && ((bits[i] >> (reste - lg)) & (nb_entrees - 1)) == v)
+			{
+				sous_symboles[n] = symboles[i];
+				sous_bits[n] = bits[i];
+				sous_longueurs[n] = longueurs[i];
+				n++;
+			}
+		}
+		
+		uint8_t sous_largeur;
+		uint32_t sous_position = construire_niveau(t, sous_symboles, sous_bits, sous_longueurs, n, decalage + lg, &sous_largeur);
+		if (sous_position == UINT32_MAX)
+		{
+			return UINT32_MAX;
+		}
+		t->entrees[position + v].valeur = sous_position; //t->entrees a pu être déplacé par realloc, on passe par l'indice
+		t->entrees[position + v].longueur = lg;
+		t->entrees[position + v].sous_bits = sous_largeur;
+	}
+	
+	return position;
+}
+
+//fonction pour créer la table de décodage des nb_symboles symboles directement à partir des longueurs de l'en tête,
+//elle renvoie NULL si une allocation échoue
+static table_decodage* creer_table(const uint8_t *longueurs, int nb_symboles)
+{
+	table_decodage *t = malloc(sizeof(table_decodage));
+	if (t == NULL)
+	{
+		return NULL;
+	}
+	t->capacite = 1 << TABLE_BITS;
+	t->entrees = malloc(t->capacite * sizeof(entree_table));
+	if (t->entrees == NULL || remplir_table(t, longueurs, nb_symboles) != HUFF_OK)
+	{
+		free(t->entrees);
+		free(t);
+		return NULL;
+	}
+	return t;
+}
+
+//fonction pour construire la table de décodage dans t->entrees, agrandi au besoin : une table de capacité fixe
+//(TABLE_FIXE_CAPACITE entrées) ne l'est jamais si les codes ont au plus LONGUEUR_FIXE_MAX bits.
+//Elle renvoie HUFF_OK, ou HUFF_ERREUR_MEMOIRE si t->entrees n'a pas pu être agrandi.
+static int remplir_table(table_decodage *t, const uint8_t *longueurs, int nb_symboles)
+{
+	t->taille = 0;
+	t->lg_max = 0;
+	code_huffman codes[NB_SYMBOLES_MAX];
+	codes_huffman(longueurs, nb_symboles, codes);
+	
+	uint16_t symboles[NB_SYMBOLES_MAX];
+	uint32_t bits[NB_SYMBOLES_MAX];
+	uint8_t lg[NB_SYMBOLES_MAX];
+	int nb = 0;
+	for (int i = 0; i < nb_symboles; i++)
+	{
+		if (codes[i].longueur == 0)
+		{
+			continue;
+		}
+		symboles[nb] = i;
+		bits[nb] = codes[i].bits;
+		lg[nb] = codes[i].longueur;
+		if (lg[nb] > t->lg_max)
+		{
+			t->lg_max = lg[nb];
+		}
+		nb++;
+	}
+	
+	return construire_niveau(t, symboles, bits, lg, nb, 0, &t->largeur) == UINT32_MAX ? HUFF_ERREUR_MEMOIRE : HUFF_OK;
+}
+
+//fonction pour libérer la mémoire de la table de décodage
+static void free_table(table_decodage *t)
+{
+	free(t->entrees);
+	free(t);
+}
+
+//fonction qui décode un caractère à partir des bits de poids fort du réservoir
+//elle renvoie le caractère, ou -1 si aucun code ne correspond à ces bits
+static inline int decoder_symbole(const table_decodage *t, uint64_t *reservoir, int *nb_bits)
+{
+	entree_table e = t->entrees[*reservoir >> (64 - t->largeur)];
+	while (e.sous_bits > 0) //le code est plus long que ce niveau : on consomme ses bits et on passe à la sous-table
+	{
+		*reservoir <<= e.longueur;
+		*nb_bits -= e.longueur;
+		e = t->entrees[e.valeur + (*reservoir >> (64 - e.sous_bits))];
+	}
+	if (e.longueur == 0)
+	{
+		return -1;
+	}
+	*reservoir <<= e.longueur;
+	*nb_bits -= e.longueur;
+	return e.valeur;
+}
+
+//fonctions pour lire les entiers du format en petit-boutiste
+static inline uint32_t lire_u32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t lire_u64(const uint8_t *p)
+{
+	return (uint64_t)lire_u32(p) | ((uint64_t)lire_u32(p + 4) << 32);
+}
+
+//fonction qui décode les caractères de s à s_fin à partir de la position du lecteur l : on décode un caractère entier
+//par accès à la table, à partir d'un réservoir de 64 bits rechargé plusieurs octets à la fois
+//elle renvoie 0, ou -1 si les données sont corrompues ou tronquées
+static int decoder_suite(const table_decodage *t, lecteur_bits *l, uint8_t *s, uint8_t *s_fin)
+{
+    	if (s < s_fin && t->lg_max == 0)
+    	{
+    		return -1; //des caractères à décoder sans aucun code Huffman
+    	}
+    	
+    	const uint8_t *p = l->p;
+    	const uint8_t *fin = l->fin;
+    	uint64_t reservoir = l->reservoir;
+    	int nb_bits = l->nb_bits;
+    	int c;
+    	
+    	//boucle rapide : tant qu'il reste au moins 8 octets on recharge le réservoir d'un coup,
+    	//puis on décode plusieurs caractères par recharge
+    	while (fin - p >= 8 && s < s_fin)
+    	{
+    		reservoir |= lire_64(p) >> nb_bits;
+    		p += (63 - nb_bits) >> 3;
+    		nb_bits |= 56;
+    		
+    		while (nb_bits >= t->lg_max && s < s_fin)
+    		{
+    			c = decoder_symbole(t, &reservoir, &nb_bits);
+    			if (c < 0)
+    			{
+				return -1;
+    			}
+    			*s++ = (uint8_t)c;
+    		}
+    	}
+    	
+    	//fin des données : on recharge octet par octet
+    	while (s < s_fin)
+    	{
+    		while (nb_bits <= 56 && p < fin)
+    		{
+    			reservoir |= (uint64_t)*p++ << (56 - nb_bits);
+    			nb_bits += 8;
+    		}
+		c = decoder_symbole(t, &reservoir, &nb_bits);
+		if (c < 0 || nb_bits < 0)
+		{
+			return -1;
+		}
+		*s++ = (uint8_t)c;
+    	}
+    	return 0;
+}
+
+//fonction qui décode un caractère dans un noyau spécialisé pour des codes d'au plus lg bits (une constante) : la descente dans
+//les sous-tables est bornée à la compilation, aucune avec lg <= TABLE_BITS. Une entrée invalide ne consomme aucun bit,
+//l'erreur est ajoutée à *erreur au lieu d'arrêter le décodage
+static inline __attribute__((always_inline)) uint8_t decoder_symbole_noyau(const entree_table *entrees, int largeur, int lg, uint64_t *reservoir, int *nb_bits, int *erreur)
+{
+	entree_table e = entrees[*reservoir >> (64 - largeur)];
+	for (int niveau = 0; niveau < (lg - 1) / TABLE_BITS && e.sous_bits > 0; niveau++)
+	{
+		*reservoir <<= e.longueur;
+		*nb_bits -= e.longueur;
+		e = entrees[e.valeur + (*reservoir >> (64 - e.sous_bits))];
+	}
+	*erreur |= e.longueur == 0;
+	*reservoir <<= e.longueur;
+	*nb_bits -= e.longueur;
+	return (uint8_t)e.valeur;
+}
+
+//noyaux de décodage générés à la compilation pour une longueur maximale des codes LG : après chaque recharge du réservoir
+//(au moins 56 bits), ils décodent exactement 56 / LG caractères par flux, une constante, sans vérifier la fin de la sortie ni
+//les erreurs à chaque caractère. La boucle s'arrête quand il reste moins de 8 octets à lire ou moins de 56 / LG caractères
+//à décoder dans un flux : la fin est décodée ensuite par decoder_suite, et les erreurs sont vérifiées une fois, à la sortie.
+//decoder_1_flux_LG et decoder_4_flux_LG avancent les lecteurs et les sorties, et renvoient -1 si une entrée invalide a été lue.
+#define DEFINIR_NOYAUX(LG) \
+static int decoder_1_flux_##LG(const table_decodage *t, lecteur_bits *l, uint8_t **s, uint8_t *s_fin) \
+{ \
+	const entree_table *entrees = t->entrees; \
+	int largeur = t->largeur; \
+	const uint8_t *p = l->p; \
+	uint64_t reservoir = l->reservoir; \
+	int nb_bits = l->nb_bits; \
+	uint8_t *d = *s; \
+	int erreur = 0; \
+	while (l->fin - p >= 8 && s_fin - d >= 56 / (LG)) \
+	{ \
+		reservoir |= lire_64(p) >> nb_bits; \
+		p += (63 - nb_bits) >> 3; \
+		nb_bits |= 56; \
+		_Pragma("GCC unroll 8") \
+		for (int j = 0; j < 56 / (LG); j++) \
+		{ \
+			d[j] = decoder_symbole_noyau(entrees, largeur, (LG), &reservoir, &nb_bits, &erreur); \
+		} \
+		d += 56 / (LG); \
+	} \
+	*l = (lecteur_bits){p, l->fin, reservoir, nb_bits}; \
+	*s = d; \
+	return -erreur; \
+} \
+ \
+static int decoder_4_flux_##LG(const table_decodage *t, lecteur_bits l[4], uint8_t *s[4], uint8_t *const s_fin[4]) \
+{ \
+	const entree_table *entrees = t->entrees; \
+	int largeur = t->largeur; \
+	const uint8_t *p0 = l[0].p, *p1 = l[1].p, *p2 = l[2].p, *p3 = l[3].p; \
+	uint64_t r0 = l[0].reservoir, r1 = l[1].reservoir, r2 = l[2].reservoir, r3 = l[3].reservoir; \
+	int n0 = l[0].nb_bits, n1 = l[1].nb_bits, n2 = l[2].nb_bits, n3 = l[3].nb_bits; \
+	uint8_t *s0 = s[0], *s1 = s[1], *s2 = s[2], *s3 = s[3]; \
+	int erreur = 0; \
+	while (l[0].fin - p0 >= 8 && l[1].fin - p1 >= 8 && l[2].fin - p2 >= 8 && l[3].fin - p3 >= 8 \
+		&& s_fin[0] - s0 >= 56 / (LG) && s_fin[1] - s1 >= 56 / (LG) && s_fin[2] - s2 >= 56 / (LG) && s_fin[3] - s3 >= 56 / (LG)) \
+	{ \
+		r0 |= lire_64(p0) >> n0; \
+		p0 += (63 - n0) >> 3; \
+		n0 |= 56; \
+		r1 |= lire_64(p1) >> n1; \
+		p1 += (63 - n1) >> 3; \
+		n1 |= 56; \
+		r2 |= lire_64(p2) >> n2; \
+		p2 += (63 - n2) >> 3; \
+		n2 |= 56; \
+		r3 |= lire_64(p3) >> n3; \
+		p3 += (63 - n3) >> 3; \
+		n3 |= 56; \
+		_Pragma("GCC unroll 8") \
+		for (int j = 0; j < 56 / (LG); j++) \
+		{ \
+			s0[j] = decoder_symbole_noyau(entrees, largeur, (LG), &r0, &n0, &erreur); \
+			s1[j] = decoder_symbole_noyau(entrees, largeur, (LG), &r1, &n1, &erreur); \
+			s2[j] = decoder_symbole_noyau(entrees, largeur, (LG), &r2, &n2, &erreur); \
+			s3[j] = decoder_symbole_noyau(entrees, largeur, (LG), &r3, &n3, &erreur); \
+		} \
+		s0 += 56 / (LG); \
+		s1 += 56 / (LG); \
+		s2 += 56 / (LG); \
+		s3 += 56 / (LG); \
+	} \
+	l[0] = (lecteur_bits){p0, l[0].fin, r0, n0}; \
+	l[1] = (lecteur_bits){p1, l[1].fin, r1, n1}; \
+	l[2] = (lecteur_bits){p2, l[2].fin, r2, n2}; \
+	l[3] = (lecteur_bits){p3, l[3].fin, r3, n3}; \
+	s[0] = s0; \
+	s[1] = s1; \
+	s[2] = s2; \
+	s[3] = s3; \
+	return -erreur; \
+}
+
+//un noyau par longueur qui change le nombre de caractères décodés par recharge (56 / LG) : 8 (7), 11 (5, sans sous-table),
+//14 (4), 18 (3), 28 (2) et 32 (1)
+DEFINIR_NOYAUX(8)
+DEFINIR_NOYAUX(11)
+DEFINIR_NOYAUX(14)
+DEFINIR_NOYAUX(18)
+DEFINIR_NOYAUX(28)
+DEFINIR_NOYAUX(32)
+
+//structure associant une longueur maximale des codes à ses noyaux de décodage
+typedef struct {
+	int lg;
+	int (*decoder_1_flux)(const table_decodage *t, lecteur_bits *l, uint8_t **s, uint8_t *s_fin);
+	int (*decoder_4_flux)(const table_decodage *t, lecteur_bits l[4], uint8_t *s[4], uint8_t *const s_fin[4]);
+} noyaux_decodage;
+
+static const noyaux_decodage noyaux[] = {
+	{8, decoder_1_flux_8, decoder_4_flux_8},
+	{11, decoder_1_flux_11, decoder_4_flux_11},
+	{14, decoder_1_flux_14, decoder_4_flux_14},
+	{18, decoder_1_flux_18, decoder_4_flux_18},
+	{28, decoder_1_flux_28, decoder_4_flux_28},
+	{LONGUEUR_MAX, decoder_1_flux_32, decoder_4_flux_32},
+};
+
+//fonction qui choisit les noyaux d'une table d'après la longueur de son plus long code, connue dès la lecture de l'en tête
+//du bloc : ceux de la plus petite longueur qui la couvre
+static const noyaux_decodage* choisir_noyaux(int lg_max)
+{
+	const noyaux_decodage *n = noyaux;
+	while (n->lg < lg_max)
+	{
+		n++;
+	}
+	return n;
+}
+
+//fonction pour décoder les n premiers caractères d'un flux de bits avec la table de décodage :
+//le noyau de la table décode le flux, puis decoder_suite décode sa fin
+static int decoder_donnees(const table_decodage *t, const uint8_t *donnees, size_t taille, uint8_t *sortie, size_t n)
+{
+	lecteur_bits l = {donnees, donnees + taille, 0, 0};
+	uint8_t *s = sortie;
+	if (t->lg_max > 0 && choisir_noyaux(t->lg_max)->decoder_1_flux(t, &l, &s, sortie + n) != 0)
+	{
+		return -1;
+	}
+	return decoder_suite(t, &l, s, sortie + n);
+}
+
+//fonction pour préparer le décodage des n premiers caractères d'un bloc codé en 4 flux (table de saut puis les 4 flux, un par quart
+//du bloc) : l reçoit un lecteur par flux, s et s_fin la partie de la sortie de chaque flux. Elle renvoie -1 si la table de saut est incohérente.
+static int ouvrir_4_flux(const uint8_t *donnees, size_t taille, uint8_t *sortie, size_t taille_originale, size_t n, lecteur_bits l[4], uint8_t *s[4], uint8_t *s_fin[4])
+{
+	if (taille < TAILLE_TABLE_SAUT)
+	{
+		return -1;
+	}
+	size_t quart = (taille_originale + 3) / 4;
+	const uint8_t *p = donnees + TAILLE_TABLE_SAUT;
+	const uint8_t *fin = donnees + taille;
+	for (int k = 0; k < 4; k++)
+	{
+		size_t taille_flux = k < 3 ? lire_u32(donnees + 4 * k) : (size_t)(fin - p);
+		if (taille_flux > (size_t)(fin - p))
+		{
+			return -1;
+		}
+		l[k] = (lecteur_bits){p, p + taille_flux, 0, 0};
+		p += taille_flux;
+		
+		size_t debut = k * quart < taille_originale ? k * quart : taille_originale; //on ne décode que les n premiers caractères du bloc
+		size_t nb = taille_originale - debut < quart ? taille_originale - debut : quart;
+		size_t fin_flux = debut + nb;
+		if (fin_flux > n)
+		{
+			fin_flux = n > debut ? n : debut;
+		}
+		s[k] = sortie + debut;
+		s_fin[k] = sortie + fin_flux;
+	}
+	return 0;
+}
+
+//fonction pour décoder les n premiers caractères d'un bloc codé en 4 flux.
+//Les 4 flux sont décodés ensemble par le noyau de la table : à chaque tour on recharge les 4 réservoirs puis on décode autant de caractères
+//de chaque flux que 56 bits en garantissent. Les 4 recherches dans la table ne dépendent pas les unes des autres, le processeur les fait en même temps.
+//Avec a non NULL, chaque flux est décodé à la suite en parcourant l'arbre (décodage de référence).
+static int decoder_4_flux(const table_decodage *t, const arbre *a, const uint8_t *donnees, size_t taille, uint8_t *sortie, size_t taille_originale, size_t n)
+{
+	lecteur_bits l[4];
+	uint8_t *s[4];
+	uint8_t *s_fin[4];
+	if (ouvrir_4_flux(donnees, taille, sortie, taille_originale, n, l, s, s_fin) != 0)
+	{
+		return -1;
+	}
+	
+	if (a != NULL)
+	{
+		for (int k = 0; k < 4; k++)
+		{
+			if (decoder_donnees_arbre(a, l[k].p, l[k].fin - l[k].p, s[k], s_fin[k] - s[k]) != 0)
+			{
+				return -1;
+			}
+		}
+		return 0;
+	}
+	if (t->lg_max == 0)
+	{
+		return n > 0 ? -1 : 0;
+	}
+	if (choisir_noyaux(t->lg_max)->decoder_4_flux(t, l, s, s_fin) != 0)
+	{
+		return -1;
+	}
+	
+	//fin des flux : chacun est terminé séparément
+	for (int k = 0; k < 4; k++)
+	{
+		if (decoder_suite(t, &l[k], s[k], s_fin[k]) != 0)
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
+
+//fonction qui décode les caractères de s à s_fin comme decoder_suite, mais chaque caractère avec la table de son contexte :
+//le caractère décodé juste avant, precedent pour le premier
+static int decoder_suite_contexte(const tables_contexte *mc, lecteur_bits *l, uint8_t *s, uint8_t *s_fin, uint8_t precedent)
+{
+    	const uint8_t *p = l->p;
+    	const uint8_t *fin = l->fin;
+    	uint64_t reservoir = l->reservoir;
+    	int nb_bits = l->nb_bits;
+    	int c = precedent;
+    	
+    	while (fin - p >= 8 && s < s_fin)
+    	{
+    		reservoir |= lire_64(p) >> nb_bits;
+    		p += (63 - nb_bits) >> 3;
+    		nb_bits |= 56;
+    		
+    		while (nb_bits >= mc->lg_max && s < s_fin)
+    		{
+    			c = decoder_symbole(mc->contextes[c], &reservoir, &nb_bits);
+    			if (c < 0)
+    			{
+				return -1;
+    			}
+    			*s++ = (uint8_t)c;
+    		}
+    	}
+    	
+    	while (s < s_fin)
+    	{
+    		while (nb_bits <= 56 && p < fin)
+    		{
+    			reservoir |= (uint64_t)*p++ << (56 - nb_bits);
+    			nb_bits += 8;
+    		}
+		c = decoder_symbole(mc->contextes[c], &reservoir, &nb_bits);
+		if (c < 0 || nb_bits < 0)
+		{
+			return -1;
+		}
+		*s++ = (uint8_t)c;
+    	}
+    	return 0;
+}
+
+//fonction pour décoder les n premiers caractères des données d'un bloc BLOC_CONTEXTE, en un ou 4 flux qui commencent chacun au contexte 0.
+//Les 4 flux sont décodés ensemble comme dans decoder_4_flux : chaque flux garde son contexte, la table change à chaque caractère
+//mais les 4 recherches restent indépendantes les unes des autres.
+static int decoder_contexte(const tables_contexte *mc, int quatre_flux, const uint8_t *donnees, size_t taille, uint8_t *sortie, size_t taille_originale, size_t n)
+{
+	if (!quatre_flux)
+	{
+		lecteur_bits l = {donnees, donnees + taille, 0, 0};
+		return decoder_suite_contexte(mc, &l, sortie, sortie + n, 0);
+	}
+	
+	lecteur_bits l[4];
+	uint8_t *s[4];
+	uint8_t *s_fin[4];
+	if (ouvrir_4_flux(donnees, taille, sortie, taille_originale, n, l, s, s_fin) != 0)
+	{
+		return -1;
+	}
+	uint8_t *s_debut[4] = {s[0], s[1], s[2], s[3]};
+	
+	ptrdiff_t par_tour = 56 / mc->lg_max;
+	const uint8_t *p0 = l[0].p, *p1 = l[1].p, *p2 = l[2].p, *p3 = l[3].p;
+	uint64_t r0 = 0, r1 = 0, r2 = 0, r3 = 0;
+	int n0 = 0, n1 = 0, n2 = 0, n3 = 0;
+	int c0 = 0, c1 = 0, c2 = 0, c3 = 0; //contexte de chaque flux
+	uint8_t *s0 = s[0], *s1 = s[1], *s2 = s[2], *s3 = s[3];
+	while (l[0].fin - p0 >= 8 && l[1].fin - p1 >= 8 && l[2].fin - p2 >= 8 && l[3].fin - p3 >= 8
+		&& s_fin[0] - s0 >= par_tour && s_fin[1] - s1 >= par_tour && s_fin[2] - s2 >= par_tour && s_fin[3] - s3 >= par_tour)
+	{
+		r0 |= lire_64(p0) >> n0;
+		p0 += (63 - n0) >> 3;
+		n0 |= 56;
+		r1 |= lire_64(p1) >> n1;
+		p1 += (63 - n1) >> 3;
+		n1 |= 56;
+		r2 |= lire_64(p2) >> n2;
+		p2 += (63 - n2) >> 3;
+		n2 |= 56;
+		r3 |= lire_64(p3) >> n3;
+		p3 += (63 - n3) >> 3;
+		n3 |= 56;
+		for (ptrdiff_t j = 0; j < par_tour; j++)
+		{
+			c0 = decoder_symbole(mc->contextes[c0], &r0, &n0);
+			c1 = decoder_symbole(mc->contextes[c1], &r1, &n1);
+			c2 = decoder_symbole(mc->contextes[c2], &r2, &n2);
+			c3 = decoder_symbole(mc->contextes[c3], &r3, &n3);
+			if ((c0 | c1 | c2 | c3) < 0)
+			{
+				return -1;
+			}
+			*s0++ = (uint8_t)c0;
+			*s1++ = (uint8_t)c1;
+			*s2++ = (uint8_t)c2;
+			*s3++ = (uint8_t)c3;
+		}
+	}
+	l[0] = (lecteur_bits){p0, l[0].fin, r0, n0};
+	l[1] = (lecteur_bits){p1, l[1].fin, r1, n1};
+	l[2] = (lecteur_bits){p2, l[2].fin, r2, n2};
+	l[3] = (lecteur_bits){p3, l[3].fin, r3, n3};
+	s[0] = s0;
+	s[1] = s1;
+	s[2] = s2;
+	s[3] = s3;
+	
+	for (int k = 0; k < 4; k++)
+	{
+		if (decoder_suite_contexte(mc, &l[k], s[k], s_fin[k], s[k] > s_debut[k] ? s[k][-1] : 0) != 0)
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
+
+//fonction pour écrire un symbole décodé d'un bloc BLOC_PLAGES : un caractère est écrit tel quel, un chiffre de plage ajoute
+//chiffre × poids répétitions du dernier caractère écrit. Le poids double à chaque chiffre et revient à 1 après un caractère.
+//Les répétitions au delà de s_fin ne sont pas écrites. Elle renvoie -1 si le symbole est invalide.
+static inline int ecrire_symbole_plages(int c, uint8_t *debut, uint8_t **s, uint8_t *s_fin, size_t *poids)
+{
+	if (c >= 0 && c < 256)
+	{
+		*(*s)++ = (uint8_t)c;
+		*poids = 1;
+		return 0;
+	}
+	if (c < 0 || *s == debut || *poids > HUFF_TAILLE_BLOC_MAX) //plage sans caractère avant elle, ou trop longue pour un bloc
+	{
+		return -1;
+	}
+	size_t n = (c == SYMBOLE_PLAGE_A ? 1 : 2) * *poids;
+	if (n > (size_t)(s_fin - *s))
+	{
+		n = s_fin - *s;
+	}
+	memset(*s, (*s)[-1], n);
+	*s += n;
+	*poids <<= 1;
+	return 0;
+}
+
+//fonction pour décoder les n premiers caractères des données d'un bloc BLOC_PLAGES, lues comme dans decoder_suite
+static int decoder_plages(const table_decodage *t, const uint8_t *donnees, size_t taille, uint8_t *sortie, size_t n)
+{
+    	const uint8_t *p = donnees;
+    	const uint8_t *fin = donnees + taille;
+    	uint64_t reservoir = 0;
+    	int nb_bits = 0;
+    	uint8_t *s = sortie;
+    	uint8_t *s_fin = sortie + n;
+    	size_t poids = 1;
+    	
+    	while (fin - p >= 8 && s < s_fin)
+    	{
+    		reservoir |= lire_64(p) >> nb_bits;
+    		p += (63 - nb_bits) >> 3;
+    		nb_bits |= 56;
+    		
+    		while (nb_bits >= t->lg_max && s < s_fin)
+    		{
+    			if (ecrire_symbole_plages(decoder_symbole(t, &reservoir, &nb_bits), sortie, &s, s_fin, &poids) != 0)
+    			{
+				return -1;
+    			}
+    		}
+    	}
+    	
+    	while (s < s_fin)
+    	{
+    		while (nb_bits <= 56 && p < fin)
+    		{
+    			reservoir |= (uint64_t)*p++ << (56 - nb_bits);
+    			nb_bits += 8;
+    		}
+		if (ecrire_symbole_plages(decoder_symbole(t, &reservoir, &nb_bits), sortie, &s, s_fin, &poids) != 0 || nb_bits < 0)
+		{
+			return -1;
+		}
+    	}
+    	return 0;
+}
+
+//fonction de décodage de référence : on parcourt l'arbre bit par bit
+static int decoder_donnees_arbre(const arbre *a, const uint8_t *donnees, size_t taille, uint8_t *sortie, size_t n)
+{
+    	uint16_t m = a->racine;
+    	size_t s = 0;
+    	for (size_t i = 0; i < taille && s < n; i++) 
+    	{
+        	for (int j = 7; j >= 0 && s < n; j--) //on parcourt des bits de l'octet en partant du bit de poids fort
+        	{
+            		int bit = (donnees[i] >> j) % 2;
+            		if (bit == 0)
+            		{
+                		m = a->noeuds[m].gauche;
+			}
+            		else
+            		{
+                		m = a->noeuds[m].droite;
+                	}
+                	if (m == AUCUN)
+                	{
+                		return -1;
+                	}
+            
+            		if (a->noeuds[m].gauche == AUCUN && a->noeuds[m].droite == AUCUN) //quand on a atteint une feuille, on a réussi à retrouver un caractère du fichier d'origine
+            		{
+		        	sortie[s++] = (uint8_t) a->noeuds[m].lettre;
+		        	m = a->racine; //on revient à la racine pour le prochain caractère
+            		}
+        	}
+    	}
+    	return s == n ? 0 : -1;
+}
+
+//fonction pour lire l'en tête des longueurs d'un bloc BLOC_TABLE et construire sa table de décodage, gardée dans tc pour les blocs
+//qui la réutilisent. *lus reçoit le nombre d'octets de l'en tête des longueurs. Elle renvoie HUFF_ERREUR_DONNEES s'il est tronqué
+//ou incohérent, HUFF_ERREUR_CONTEXTE si ses codes ne tiennent pas dans la table de capacité fixe de tc, ou HUFF_ERREUR_MEMOIRE.
+static int charger_table(const uint8_t *bloc, size_t taille, table_courante *tc, size_t *lus)
+{
+	free_table_courante(tc);
+	*lus = lire_longueurs(bloc + TAILLE_EN_TETE_BLOC, taille - TAILLE_EN_TETE_BLOC, tc->longueurs);
+	if (*lus == 0)
+	{
+		return HUFF_ERREUR_DONNEES;
+	}
+	if (tc->fixe == NULL)
+	{
+		tc->table = creer_table(tc->longueurs, 256);
+		return tc->table != NULL ? HUFF_OK : HUFF_ERREUR_MEMOIRE;
+	}
+	for (int i = 0; i < 256; i++)
+	{
+		if (tc->longueurs[i] > LONGUEUR_FIXE_MAX)
+		{
+			return HUFF_ERREUR_CONTEXTE;
+		}
+	}
+	remplir_table(tc->fixe, tc->longueurs, 256); //des codes d'au plus LONGUEUR_FIXE_MAX bits tiennent dans la table sans l'agrandir
+	tc->table = tc->fixe;
+	return HUFF_OK;
+}
+
+//fonction pour libérer la table gardée dans tc
+static void free_table_courante(table_courante *tc)
+{
+	if (tc->table != NULL && tc->table != tc->fixe) //la table de capacité fixe appartient à l'appelant
+	{
+		free_table(tc->table);
+	}
+	tc->table = NULL;
+	tc->bloc = UINT32_MAX;
+}
+
+//fonction pour lire l'en tête d'un bloc BLOC_CONTEXTE et construire la table de chaque groupe. *lus reçoit le nombre d'octets lus.
+//Elle renvoie HUFF_OK, HUFF_ERREUR_DONNEES si l'en tête est tronqué ou incohérent ou HUFF_ERREUR_MEMOIRE (mc est alors libéré).
+static int charger_contexte(const uint8_t *p, size_t taille, tables_contexte *mc, size_t *lus)
+{
+	mc->nb_groupes = 0;
+	mc->lg_max = 0;
+	if (taille < 1 + 128 || p[0] == 0 || p[0] > NB_GROUPES_MAX)
+	{
+		return HUFF_ERREUR_DONNEES;
+	}
+	*lus = 1 + 128;
+	for (int g = 0; g < p[0]; g++)
+	{
+		uint8_t longueurs[256];
+		size_t t = lire_longueurs(p + *lus, taille - *lus, longueurs);
+		if (t == 0)
+		{
+			free_tables_contexte(mc);
+			return HUFF_ERREUR_DONNEES;
+		}
+		*lus += t;
+		mc->tables[g] = creer_table(longueurs, 256);
+		if (mc->tables[g] == NULL)
+		{
+			free_tables_contexte(mc);
+			return HUFF_ERREUR_MEMOIRE;
+		}
+		mc->nb_groupes++;
+		if (mc->tables[g]->lg_max == 0) //un groupe sans aucun code
+		{
+			free_tables_contexte(mc);
+			return HUFF_ERREUR_DONNEES;
+		}
+		mc->lg_max = mc->tables[g]->lg_max > mc->lg_max ? mc->tables[g]->lg_max : mc->lg_max;
+	}
+	for (int c = 0; c < 256; c++)
+	{
+		int g = (p[1 + c / 2] >> (4 * (c % 2))) & 15;
+		if (g >= mc->nb_groupes)
+		{
+			free_tables_contexte(mc);
+			return HUFF_ERREUR_DONNEES;
+		}
+		mc->contextes[c] = mc->tables[g];
+	}
+	return HUFF_OK;
+}
+
+//fonction pour libérer les tables des groupes d'un bloc BLOC_CONTEXTE
+static void free_tables_contexte(tables_contexte *mc)
+{
+	for (int g = 0; g < mc->nb_groupes; g++)
+	{
+		free_table(mc->tables[g]);
+	}
+	mc->nb_groupes = 0;
+}
+
+//fonction pour lire l'en tête d'un bloc BLOC_PLAGES (longueurs des caractères puis des 2 symboles de plage) et construire sa table
+//dans *table. *lus reçoit le nombre d'octets lus. Elle renvoie HUFF_OK, HUFF_ERREUR_DONNEES si l'en tête est tronqué ou incohérent,
+//ou HUFF_ERREUR_MEMOIRE.
+static int charger_plages(const uint8_t *p, size_t taille, table_decodage **table, size_t *lus)
+{
+	uint8_t longueurs[NB_SYMBOLES_MAX];
+	*table = NULL;
+	*lus = lire_longueurs(p, taille, longueurs);
+	if (*lus == 0 || taille - *lus < 2)
+	{
+		return HUFF_ERREUR_DONNEES;
+	}
+	longueurs[SYMBOLE_PLAGE_A] = p[*lus];
+	longueurs[SYMBOLE_PLAGE_B] = p[*lus + 1];
+	*lus += 2;
+	if (!code_prefixe(longueurs, NB_SYMBOLES_MAX))
+	{
+		return HUFF_ERREUR_DONNEES;
+	}
+	table_decodage *t = creer_table(longueurs, NB_SYMBOLES_MAX);
+	if (t == NULL)
+	{
+		return HUFF_ERREUR_MEMOIRE;
+	}
+	if (t->lg_max == 0)
+	{
+		free_table(t);
+		return HUFF_ERREUR_DONNEES;
+	}
+	*table = t;
+	return HUFF_OK;
+}
+
+//fonction pour décoder les n premiers caractères d'un bloc (en tête du bloc, puis selon son type table, identifiant du dictionnaire,
+//tables des groupes de contextes ou rien, puis données en un ou 4 flux) dans sortie. Un bloc BLOC_REUTILISE est décodé avec la table gardée dans tc.
+//Les blocs BLOC_CONTEXTE et BLOC_PLAGES sont toujours décodés avec les tables, même avec l'option arbre.
+//Elle renvoie HUFF_OK, HUFF_ERREUR_DONNEES, HUFF_ERREUR_DICTIONNAIRE si le bloc a été compressé avec un autre dictionnaire
+//que celui des options, HUFF_ERREUR_CONTEXTE si ses tables ne tiennent pas dans la table de capacité fixe de tc, ou HUFF_ERREUR_MEMOIRE. Si st n'est pas NULL, les mesures du bloc y sont ajoutées.
+static int decoder_bloc(const uint8_t *bloc, size_t taille, uint8_t *sortie, size_t taille_originale, size_t n, const huff_options *o, table_courante *tc, huff_stats *st)
+{
+	if (taille < TAILLE_EN_TETE_BLOC || lire_u32(bloc + 1) != taille_originale || n > taille_originale
+		|| TAILLE_EN_TETE_BLOC + (size_t)lire_u32(bloc + 5) != taille)
+	{
+		return HUFF_ERREUR_DONNEES;
+	}
+	chrono t;
+	demarrer_chrono(&t, st);
+	if (st != NULL)
+	{
+		st->blocs++;
+		st->octets_entree += taille;
+		st->octets_sortie += n;
+	}
+	
+	int type = TYPE_BLOC(bloc[0]);
+	int quatre_flux = (bloc[0] & BLOC_4_FLUX) != 0;
+	const uint8_t *longueurs = tc->longueurs;
+	const table_decodage *table = tc->table; //la table du dictionnaire est construite une seule fois, au chargement
+	tables_contexte mc = {0};
+	table_decodage *table_plages = NULL;
+	size_t lus = 0;
+	if (type == BLOC_TABLE)
+	{
+		int r = charger_table(bloc, taille, tc, &lus);
+		if (r != HUFF_OK)
+		{
+			return r;
+		}
+		table = tc->table;
+	}
+	else if (type == BLOC_REUTILISE)
+	{
+		if (table == NULL)
+		{
+			return HUFF_ERREUR_DONNEES; //aucun bloc BLOC_TABLE avant ce bloc
+		}
+	}
+	else if (type == BLOC_BRUT)
+	{
+		if (quatre_flux || taille - TAILLE_EN_TETE_BLOC != taille_originale)
+		{
+			return HUFF_ERREUR_DONNEES;
+		}
+		memcpy(sortie, bloc + TAILLE_EN_TETE_BLOC, n);
+		int r = verifier_bloc(bloc, sortie, taille_originale, n);
+		mesurer_phase(&t, st, HUFF_PHASE_DECODAGE);
+		return r;
+	}
+	else if (type == BLOC_CONSTANT)
+	{
+		if (quatre_flux || taille != TAILLE_EN_TETE_BLOC + 1)
+		{
+			return HUFF_ERREUR_DONNEES;
+		}
+		memset(sortie, bloc[TAILLE_EN_TETE_BLOC], n);
+		int r = verifier_bloc(bloc, sortie, taille_originale, n);
+		mesurer_phase(&t, st, HUFF_PHASE_DECODAGE);
+		return r;
+	}
+	else if (type == BLOC_DICTIONNAIRE)
+	{
+		if (taille < TAILLE_EN_TETE_BLOC + 4)
+		{
+			return HUFF_ERREUR_DONNEES;
+		}
+		const huff_dictionnaire *d = o->dictionnaire;
+		if (d == NULL || d->table == NULL || lire_u32(bloc + TAILLE_EN_TETE_BLOC) != d->id)
+		{
+			return HUFF_ERREUR_DICTIONNAIRE;
+		}
+		longueurs = d->longueurs;
+		table = d->table;
+		lus = 4;
+	}
+	else if ((type == BLOC_CONTEXTE || type == BLOC_PLAGES) && tc->fixe != NULL)
+	{
+		return HUFF_ERREUR_CONTEXTE; //leurs tables ne tiennent pas dans un huff_contexte
+	}
+	else if (type == BLOC_CONTEXTE)
+	{
+		int r = charger_contexte(bloc + TAILLE_EN_TETE_BLOC, taille - TAILLE_EN_TETE_BLOC, &mc, &lus);
+		if (r != HUFF_OK)
+		{
+			return r;
+		}
+		table = NULL;
+	}
+	else if (type == BLOC_PLAGES)
+	{
+		if (quatre_flux)
+		{
+			return HUFF_ERREUR_DONNEES;
+		}
+		int r = charger_plages(bloc + TAILLE_EN_TETE_BLOC, taille - TAILLE_EN_TETE_BLOC, &table_plages, &lus);
+		if (r != HUFF_OK)
+		{
+			return r;
+		}
+		table = table_plages;
+	}
+	else
+	{
+		return HUFF_ERREUR_DONNEES;
+	}
+	const uint8_t *donnees = bloc + TAILLE_EN_TETE_BLOC + lus;
+	size_t taille_codee = taille - TAILLE_EN_TETE_BLOC - lus;
+	mesurer_phase(&t, st, HUFF_PHASE_TABLES);
+	
+	int r = 0;
+	arbre arb;
+	if (type == BLOC_CONTEXTE)
+	{
+		r = decoder_contexte(&mc, quatre_flux, donnees, taille_codee, sortie, taille_originale, n);
+	}
+	else if (type == BLOC_PLAGES)
+	{
+		r = decoder_plages(table_plages, donnees, taille_codee, sortie, n);
+	}
+	else if (o->arbre) //décodage de référence
+	{
+    		code_huffman codes[256]; //on déclare un tableau pour stocker les codes Huffman pour chaque caractère
+    		codes_huffman(longueurs, 256, codes);
+ 
+    		arb.nb_noeuds = 0; //on va reconstruire l'arbre des codes Huffman à partir du tableau codes
+    		arb.racine = creer_noeud(&arb);
+    		for (int i = 0; i < 256 && r == 0; i++) 
+    		{
+        		if (codes[i].longueur > 0) 
+        		{
+            			r = remplace(&arb, codes[i], (uint8_t)i);
+        		}
+    		}
+	}
+	if (r == 0 && type != BLOC_CONTEXTE && type != BLOC_PLAGES)
+	{
+		if (quatre_flux)
+		{
+			r = decoder_4_flux(table, o->arbre ? &arb : NULL, donnees, taille_codee, sortie, taille_originale, n);
+		}
+		else if (o->arbre)
+		{
+    			r = decoder_donnees_arbre(&arb, donnees, taille_codee, sortie, n);
+		}
+		else
+		{
+			r = decoder_donnees(table, donnees, taille_codee, sortie, n);
+		}
+	}
+	r = r == 0 ? verifier_bloc(bloc, sortie, taille_originale, n) : HUFF_ERREUR_DONNEES;
+	mesurer_phase(&t, st, HUFF_PHASE_DECODAGE);
+	if (st != NULL)
+	{
+		st->caracteres += n;
+		st->bits += (uint64_t)taille_codee * 8;
+		st->lg_max = table != NULL && table->lg_max > st->lg_max ? table->lg_max : st->lg_max;
+		st->lg_max = (uint32_t)mc.lg_max > st->lg_max ? (uint32_t)mc.lg_max : st->lg_max;
+	}
+	free_tables_contexte(&mc);
+	if (table_plages != NULL)
+	{
+		free_table(table_plages);
+	}
+	return r;
+}
+
+//fonction pour vérifier le CRC32C d'un bloc décodé en entier : un bloc décodé en partie (intervalle) n'est pas vérifié
+static int verifier_bloc(const uint8_t *bloc, const uint8_t *sortie, size_t taille_originale, size_t n)
+{
+	if (n == taille_originale && crc32c(sortie, n) != lire_u32(bloc + 9))
+	{
+		return HUFF_ERREUR_DONNEES;
+	}
+	return HUFF_OK;
+}
+
+//fonction pour décoder les n premiers caractères du bloc i de l'index : pour un bloc BLOC_REUTILISE, on charge d'abord
+//la table du bloc qui l'a définie, si tc ne la contient pas déjà
+static int decoder_bloc_index(const uint8_t *src, const bloc_index *blocs, uint32_t i, uint8_t *sortie, size_t n, const huff_options *o, table_courante *tc, huff_stats *st)
+{
+	const bloc_index *b = &blocs[i];
+	if (b->table != UINT32_MAX && b->table != i && tc->bloc != b->table)
+	{
+		chrono c;
+		demarrer_chrono(&c, st);
+		const bloc_index *t = &blocs[b->table];
+		size_t lus;
+		int r = t->taille < TAILLE_EN_TETE_BLOC ? HUFF_ERREUR_DONNEES : charger_table(src + t->position, t->taille, tc, &lus);
+		if (r != HUFF_OK)
+		{
+			free_table_courante(tc);
+			return r == HUFF_ERREUR_MEMOIRE ? r : HUFF_ERREUR_DONNEES;
+		}
+		tc->bloc = b->table;
+		mesurer_phase(&c, st, HUFF_PHASE_TABLES);
+	}
+	
+	int r = decoder_bloc(src + b->position, b->taille, sortie, b->taille_originale, n, o, tc, st);
+	if (b->table == i) //la table chargée est celle de ce bloc
+	{
+		tc->bloc = r == HUFF_OK ? i : UINT32_MAX;
+	}
+	return r;
+}
+
+//fonction pour compresser un bloc avec les codes d'un dictionnaire : ni comptage des caractères ni construction de l'arbre,
+//l'en tête des longueurs est remplacé par l'identifiant du dictionnaire. Si le bloc codé est plus gros que le bloc, il est stocké brut.
+//Elle renvoie NULL si l'allocation échoue.
+static uint8_t* compresser_bloc_dictionnaire(const uint8_t *donnees, size_t taille, const huff_dictionnaire *d, int nb_flux, size_t *taille_sortie)
+{
+    	//les codes du dictionnaire ont au moins 8 bits, le bloc brut tient aussi dans cette place
+    	uint8_t *sortie = malloc(TAILLE_EN_TETE_BLOC + 4 + FLUX_SURCOUT + (taille * d->lg_max + 7) / 8 + 8);
+    	if (sortie == NULL)
+    	{
+    		return NULL;
+    	}
+    	*taille_sortie = coder_bloc_dictionnaire(sortie, donnees, taille, d, nb_flux);
+    	return sortie;
+}
+
+//fonction pour écrire dans sortie un bloc codé avec les codes d'un dictionnaire, ou le bloc brut s'il est plus petit.
+//Elle renvoie la taille du bloc.
+static size_t coder_bloc_dictionnaire(uint8_t *sortie, const uint8_t *donnees, size_t taille, const huff_dictionnaire *d, int nb_flux)
+{
+    	size_t taille_codee = encoder_flux(donnees, taille, d->codes, NULL, nb_flux, sortie + TAILLE_EN_TETE_BLOC + 4);
+    	if (4 + taille_codee > taille)
+    	{
+    		return coder_bloc(sortie, BLOC_BRUT, donnees, taille, NULL, NULL, 1);
+    	}
+    	size_t t = TAILLE_EN_TETE_BLOC + 4 + taille_codee;
+    	ecrire_en_tete_bloc(sortie, nb_flux == 4 ? BLOC_DICTIONNAIRE | BLOC_4_FLUX : BLOC_DICTIONNAIRE, donnees, taille, t);
+    	ecrire_u32(sortie + TAILLE_EN_TETE_BLOC, d->id);
+    	return t;
+}
+
+//fonction pour écrire un message court dans sortie, qui a la place donnée par huff_taille_max : le magic puis le bloc codé
+//avec le dictionnaire des options (ou brut). tab reçoit les apparitions des caractères si les mesures sont demandées.
+//Elle renvoie la taille du message.
+static size_t ecrire_message(uint8_t *sortie, const uint8_t *donnees, size_t taille, const huff_options *o, uint64_t tab[256])
+{
+	huff_stats mesures = {0};
+	huff_stats *st = o->stats != NULL ? &mesures : NULL;
+	chrono t;
+	demarrer_chrono(&t, st);
+	ecrire_u32(sortie, MAGIC_MESSAGE);
+	size_t taille_message = TAILLE_EN_TETE_MESSAGE + coder_bloc_dictionnaire(sortie + TAILLE_EN_TETE_MESSAGE, donnees, taille, o->dictionnaire, nb_flux_bloc(o, taille));
+	mesurer_phase(&t, st, HUFF_PHASE_CODAGE);
+	if (st != NULL)
+	{
+		if (TYPE_BLOC(sortie[TAILLE_EN_TETE_MESSAGE]) == BLOC_DICTIONNAIRE)
+		{
+			apparitions(donnees, taille, tab); //seulement pour les mesures, hors des phases
+			compter_caracteres(st, tab, o->dictionnaire->longueurs, taille);
+		}
+		st->octets_entree += taille;
+		st->octets_sortie += taille_message;
+		st->blocs++;
+		ajouter_stats(o->stats, st);
+	}
+	return taille_message;
+}
+
+//fonction qui renvoie la taille du bloc d'un message court, ou 0 si src n'est pas un message complet et cohérent
+static size_t taille_message(const uint8_t *src, size_t taille)
+{
+	if (taille < TAILLE_EN_TETE_MESSAGE + TAILLE_EN_TETE_BLOC || lire_u32(src) != MAGIC_MESSAGE)
+	{
+		return 0;
+	}
+	size_t taille_bloc = taille_bloc_flux(src + TAILLE_EN_TETE_MESSAGE);
+	return taille_bloc == taille - TAILLE_EN_TETE_MESSAGE ? taille_bloc : 0;
+}
+
+//fonction pour estimer sur un échantillon si un bloc est incompressible (données déjà compressées ou chiffrées) : on compte les
+//caractères de ECHANTILLON_MORCEAUX morceaux répartis dans le bloc, et si les codes de Huffman de l'échantillon ne gagnent pas
+//au moins 1/64 de sa taille, le bloc est stocké brut sans compter tous ses caractères. Les petits blocs sont comptés en entier.
+static int bloc_incompressible(const uint8_t *donnees, size_t taille, int lg_max)
+{
+	if (taille < ECHANTILLON_BLOC_MIN)
+	{
+		return 0;
+	}
+	
+	uint64_t tab[256] = {0};
+	size_t pas = taille / ECHANTILLON_MORCEAUX;
+	for (size_t k = 0; k < ECHANTILLON_MORCEAUX; k++)
+	{
+		const uint8_t *p = donnees + k * pas;
+		for (size_t j = 0; j < ECHANTILLON_MORCEAU; j++)
+		{
+			tab[p[j]]++;
+		}
+	}
+	
+	uint8_t longueurs[256];
+	if (longueurs_bloc(tab, 256, lg_max, longueurs) != 0)
+	{
+		return 0; //le bloc complet décidera
+	}
+	uint64_t t = taille_codee(tab, 256, longueurs);
+	return t != UINT64_MAX && t >= ECHANTILLON_MORCEAUX * ECHANTILLON_MORCEAU * 63 / 64;
+}
+
+//fonction pour choisir le codage d'un bloc d'après ses apparitions, appelée dans l'ordre des blocs : réutiliser la table precedente
+//du dernier bloc qui en a une (NULL s'il n'y en a pas, ni arbre ni en tête), une nouvelle table avec son en tête, un codage préparé en parallèle (alternative :
+//BLOC_CONTEXTE ou BLOC_PLAGES) dont la taille, surcout compris, est taille_alternative (UINT64_MAX sans alternative), ou le bloc brut.
+//surcout est ajouté aux tailles codées (table de saut des blocs en 4 flux).
+//Elle renvoie le type du bloc, longueurs reçoit les longueurs à utiliser et *taille_prevue la taille des données du bloc.
+static int choisir_codage(const uint8_t *precedente, int lg_max, const uint64_t tab[256], size_t taille, uint64_t surcout, int alternative, uint64_t taille_alternative, uint8_t longueurs[256], uint64_t *taille_prevue)
+{
+	uint64_t taille_reutilise = precedente != NULL ? taille_codee(tab, 256, precedente) : UINT64_MAX;
+	if (taille_reutilise != UINT64_MAX)
+	{
+		taille_reutilise += surcout;
+	}
+	uint64_t taille_nouvelle = UINT64_MAX;
+	uint8_t en_tete_nouvelle[EN_TETE_TAILLE_MAX];
+	if (longueurs_bloc(tab, 256, lg_max, longueurs) == 0)
+	{
+		taille_nouvelle = taille_codee(tab, 256, longueurs);
+		if (taille_nouvelle != UINT64_MAX)
+		{
+			taille_nouvelle += en_tete(en_tete_nouvelle, longueurs) + surcout;
+		}
+	}
+	
+	if (taille_alternative < taille_reutilise && taille_alternative < taille_nouvelle && taille_alternative < taille)
+	{
+		*taille_prevue = taille_alternative;
+		return alternative; //la table précédente n'est pas changée
+	}
+	if (taille_reutilise <= taille_nouvelle && taille_reutilise <= taille)
+	{
+		*taille_prevue = taille_reutilise;
+		memcpy(longueurs, precedente, 256);
+		return BLOC_REUTILISE;
+	}
+	if (taille <= taille_nouvelle)
+	{
+		*taille_prevue = taille;
+		return BLOC_BRUT; //la table précédente n'est pas changée
+	}
+	*taille_prevue = taille_nouvelle;
+	return BLOC_TABLE; //ses longueurs deviennent la table à réutiliser
+}
+
+//fonction pour compresser le bloc numéro i : ses caractères sont comptés en parallèle avec les autres blocs, puis le codage
+//est choisi dans l'ordre des blocs, car il dépend de la table en vigueur après le bloc précédent. Le codage lui-même se fait en parallèle.
+//Un bloc incompressible d'après son échantillon est stocké brut, un bloc d'un seul caractère répété est stocké en un octet.
+//L'échantillon ne mesure que l'ordre 0 : avec l'ordre 1 ou les plages, un bloc sans gain à l'ordre 0 peut être très prévisible
+//par contexte ou fait de longues plages, il n'est donc utilisé qu'à l'ordre 0 sans plages.
+//Avec l'ordre 1 ou le codage des plages, le modèle par contexte ou les symboles de plage du bloc sont calculés en parallèle eux aussi,
+//et ne sont gardés que s'ils donnent le plus petit bloc. Si une allocation échoue, b->resultat reste NULL : le bloc passe quand même
+//par le choix du codage pour ne pas bloquer les blocs suivants, et l'erreur est rendue à son écriture.
+static void compresser_bloc(huff_compresseur *c, uint64_t i, emplacement *b)
+{
+	huff_stats mesures = {0};
+	huff_stats *st = c->o.stats != NULL ? &mesures : NULL; //les mesures du bloc sont ajoutées à la fin
+	chrono t;
+	demarrer_chrono(&t, st);
+	uint64_t tab[256]; //tableau avec le nombre d'apparitions d'un caractère
+	if (c->o.dictionnaire != NULL)
+	{
+		const huff_dictionnaire *d = c->o.dictionnaire;
+		b->resultat = compresser_bloc_dictionnaire(b->donnees, b->taille, d, nb_flux_bloc(&c->o, b->taille), &b->taille_resultat);
+		mesurer_phase(&t, st, HUFF_PHASE_CODAGE);
+		if (st != NULL && b->resultat != NULL)
+		{
+			if (TYPE_BLOC(b->resultat[0]) == BLOC_DICTIONNAIRE)
+			{
+				apparitions(b->donnees, b->taille, tab); //seulement pour les mesures, hors des phases
+				compter_caracteres(st, tab, d->longueurs, b->taille);
+			}
+			ajouter_stats(c->o.stats, st);
+		}
+		return;
+	}
+	
+	int type = BLOC_TABLE;
+	uint64_t taille_prevue = b->taille;
+	if (c->o.ordre == 0 && !c->o.plages && bloc_incompressible(b->donnees, b->taille, c->o.lg_max))
+	{
+		type = BLOC_BRUT;
+	}
+	else
+	{
+		apparitions(b->donnees, b->taille, tab);
+		if (b->taille > 0 && tab[b->donnees[0]] == b->taille)
+		{
+			type = BLOC_CONSTANT;
+			taille_prevue = 1;
+		}
+	}
+	
+	mesurer_phase(&t, st, HUFF_PHASE_HISTOGRAMME);
+	
+	int nb_flux = nb_flux_bloc(&c->o, b->taille);
+	histogramme_contexte *h = NULL;
+	modele_contexte modele;
+	uint64_t taille_contexte = UINT64_MAX;
+	int memoire = 1; //0 si une allocation a échoué
+	if (c->o.ordre == 1 && type == BLOC_TABLE && b->taille >= CONTEXTE_BLOC_MIN && (memoire = (h = malloc(sizeof(histogramme_contexte))) != NULL))
+	{
+		apparitions_contexte(b->donnees, b->taille, nb_flux, h);
+		mesurer_phase(&t, st, HUFF_PHASE_HISTOGRAMME);
+		taille_contexte = modele_ordre_1(h, c->o.lg_max, nb_flux == 4 ? FLUX_SURCOUT : 0, &modele);
+		mesurer_phase(&t, st, HUFF_PHASE_ARBRE);
+	}
+	uint64_t symboles[NB_SYMBOLES_MAX]; //apparitions des caractères et des symboles de plage
+	uint8_t longueurs_plages[NB_SYMBOLES_MAX];
+	uint64_t taille_avec_plages = UINT64_MAX;
+	if (c->o.plages && type == BLOC_TABLE)
+	{
+		apparitions_plages(b->donnees, b->taille, symboles);
+		mesurer_phase(&t, st, HUFF_PHASE_HISTOGRAMME);
+		taille_avec_plages = taille_plages(symboles, c->o.lg_max, longueurs_plages);
+		mesurer_phase(&t, st, HUFF_PHASE_ARBRE);
+	}
+	
+	pthread_mutex_lock(&c->verrou);
+	while (c->choisis != i)
+	{
+		pthread_cond_wait(&c->table_choisie, &c->verrou);
+	}
+	pthread_mutex_unlock(&c->verrou);
+	demarrer_chrono(&t, st); //l'attente des blocs précédents n'est pas comptée
+	
+	uint8_t longueurs[256];
+	if (type == BLOC_TABLE)
+	{
+		int alternative = taille_avec_plages < taille_contexte ? BLOC_PLAGES : BLOC_CONTEXTE;
+		type = choisir_codage(c->table_valide ? c->longueurs : NULL, c->o.lg_max, tab, b->taille, nb_flux == 4 ? FLUX_SURCOUT : 0,
+			alternative, alternative == BLOC_PLAGES ? taille_avec_plages : taille_contexte, longueurs, &taille_prevue);
+		if (type == BLOC_TABLE)
+		{
+			memcpy(c->longueurs, longueurs, 256);
+			c->table_valide = 1;
+		}
+	}
+	mesurer_phase(&t, st, HUFF_PHASE_ARBRE);
+	
+	pthread_mutex_lock(&c->verrou);
+	c->choisis++;
+	pthread_cond_broadcast(&c->table_choisie);
+	pthread_mutex_unlock(&c->verrou);
+	demarrer_chrono(&t, st);
+	
+	if (!memoire)
+	{
+		b->resultat = NULL;
+	}
+	else if (type == BLOC_CONTEXTE)
+	{
+		b->resultat = ecrire_bloc_contexte(&modele, b->donnees, b->taille, nb_flux, taille_prevue, &b->taille_resultat);
+	}
+	else if (type == BLOC_PLAGES)
+	{
+		b->resultat = ecrire_bloc_plages(longueurs_plages, b->donnees, b->taille, taille_prevue, &b->taille_resultat);
+	}
+	else
+	{
+		b->resultat = ecrire_bloc(type, b->donnees, b->taille, longueurs, nb_flux, taille_prevue, &b->taille_resultat);
+	}
+	mesurer_phase(&t, st, HUFF_PHASE_CODAGE);
+	if (st != NULL && b->resultat != NULL)
+	{
+		if (type == BLOC_TABLE || type == BLOC_REUTILISE)
+		{
+			compter_caracteres(st, tab, longueurs, b->taille);
+		}
+		else if (type == BLOC_CONTEXTE)
+		{
+			compter_caracteres_contexte(st, h, &modele, b->taille);
+		}
+		else if (type == BLOC_PLAGES)
+		{
+			compter_caracteres_plages(st, tab, symboles, longueurs_plages, b->taille);
+		}
+		ajouter_stats(c->o.stats, st);
+	}
+	free(h);
+}
+
+//fonction pour construire les codes et la table de décodage d'un dictionnaire à partir de ses longueurs,
+//l'identifiant est le hachage FNV-1a des 256 longueurs : le même dictionnaire a toujours le même identifiant.
+//Elle renvoie HUFF_OK, ou HUFF_ERREUR_MEMOIRE si la table n'a pas pu être construite (d->table vaut alors NULL).
+static int preparer_dictionnaire(huff_dictionnaire *d)
+{
+	codes_huffman(d->longueurs, 256, d->codes);
+	d->lg_max = 0;
+	d->id = 2166136261u;
+	for (int i = 0; i < 256; i++)
+	{
+		if (d->longueurs[i] > d->lg_max)
+		{
+			d->lg_max = d->longueurs[i];
+		}
+		d->id = (d->id ^ d->longueurs[i]) * 16777619u;
+	}
+	if (d->table != NULL)
+	{
+		free_table(d->table);
+	}
+	d->table = creer_table(d->longueurs, 256);
+	return d->table != NULL ? HUFF_OK : HUFF_ERREUR_MEMOIRE;
+}
+
+//fonction pour créer un dictionnaire vide, à entraîner sur des échantillons, elle renvoie NULL si l'allocation échoue
+huff_dictionnaire* huff_dictionnaire_creer(void)
+{
+	return calloc(1, sizeof(huff_dictionnaire));
+}
+
+//fonction pour ajouter un échantillon aux comptes du dictionnaire
+void huff_dictionnaire_ajouter(huff_dictionnaire *d, const void *echantillon, size_t taille)
+{
+	uint64_t tab[256];
+	apparitions(echantillon, taille, tab);
+	for (int i = 0; i < 256; i++)
+	{
+		d->apparitions[i] += tab[i];
+	}
+}
+
+//fonction pour calculer la table du dictionnaire à partir des échantillons ajoutés : chaque compte est augmenté de 1
+//pour que les caractères absents des échantillons aient aussi un code, il faut donc lg_max >= 8
+int huff_dictionnaire_entrainer(huff_dictionnaire *d, int lg_max)
+{
+	if (lg_max < 8 || lg_max > LONGUEUR_MAX)
+	{
+		return HUFF_ERREUR_PARAMETRE;
+	}
+	uint64_t tab[256];
+	for (int i = 0; i < 256; i++)
+	{
+		tab[i] = d->apparitions[i] + 1;
+	}
+	
+	arbre arb;
+	creer_arbre(tab, 256, &arb);
+	if (longueurs_huffman(&arb, d->longueurs) > lg_max)
+	{
+		longueurs_limitees(tab, 256, lg_max, d->longueurs);
+	}
+	return preparer_dictionnaire(d);
+}
+
+//fonction pour écrire le dictionnaire dans dst (au plus HUFF_TAILLE_DICTIONNAIRE_MAX octets) :
+//son identifiant puis l'en tête de ses longueurs, elle renvoie le nombre d'octets écrits
+size_t huff_dictionnaire_ecrire(const huff_dictionnaire *d, void *dst)
+{
+	ecrire_u32(dst, d->id);
+	return 4 + en_tete((uint8_t *)dst + 4, d->longueurs);
+}
+
+//fonction pour lire un dictionnaire écrit par huff_dictionnaire_ecrire, elle renvoie NULL s'il est invalide ou si une allocation échoue.
+//Comme après l'entraînement, chaque caractère doit avoir un code : un bloc codé avec le dictionnaire peut contenir n'importe quel octet.
+huff_dictionnaire* huff_dictionnaire_lire(const void *src, size_t taille)
+{
+	const uint8_t *p = src;
+	huff_dictionnaire *d = huff_dictionnaire_creer();
+	if (d == NULL)
+	{
+		return NULL;
+	}
+	if (taille < 4 || lire_longueurs(p + 4, taille - 4, d->longueurs) != taille - 4 || memchr(d->longueurs, 0, 256) != NULL)
+	{
+		free(d);
+		return NULL;
+	}
+	if (preparer_dictionnaire(d) != HUFF_OK || d->id != lire_u32(p)) //l'identifiant est recalculé à partir des longueurs
+	{
+		huff_dictionnaire_liberer(d);
+		return NULL;
+	}
+	return d;
+}
+
+//fonction qui renvoie l'identifiant du dictionnaire, écrit dans chaque bloc compressé avec lui
+uint32_t huff_dictionnaire_id(const huff_dictionnaire *d)
+{
+	return d->id;
+}
+
+//fonction pour libérer un dictionnaire
+void huff_dictionnaire_liberer(huff_dictionnaire *d)
+{
+	if (d == NULL)
+	{
+		return;
+	}
+	if (d->table != NULL)
+	{
+		free_table(d->table);
+	}
+	free(d);
+}
+
+//fonction exécutée par chaque thread de compression : on prend le prochain bloc rempli tant qu'il en reste
+static void* thread_compression(void *arg)
+{
+	huff_compresseur *c = arg;
+	pthread_mutex_lock(&c->verrou);
+	for (;;)
+	{
+		while (c->suivant >= c->lus && !c->fin_entree) //on attend que le thread appelant remplisse un bloc
+		{
+			pthread_cond_wait(&c->bloc_lu, &c->verrou);
+		}
+		if (c->suivant >= c->lus)
+		{
+			break;
+		}
+		uint64_t i = c->suivant++;
+		emplacement *b = &c->emplacements[i % c->fenetre];
+		pthread_mutex_unlock(&c->verrou);
+		
+		compresser_bloc(c, i, b);
+		
+		pthread_mutex_lock(&c->verrou);
+		b->pret = 1;
+		pthread_cond_broadcast(&c->bloc_pret);
+	}
+	pthread_mutex_unlock(&c->verrou);
+	return NULL;
+}
+
+//fonction pour donner un bloc rempli aux threads de compression, ou le compresser tout de suite s'il n'y a pas de threads
+static void publier(huff_compresseur *c, emplacement *b, const uint8_t *donnees, size_t taille)
+{
+	b->donnees = donnees;
+	b->taille = taille;
+	if (c->threads == NULL)
+	{
+		compresser_bloc(c, c->suivant++, b);
+		b->pret = 1;
+		c->lus++;
+		return;
+	}
+	pthread_mutex_lock(&c->verrou);
+	c->lus++;
+	pthread_cond_broadcast(&c->bloc_lu);
+	pthread_mutex_unlock(&c->verrou);
+}
+
+//fonction pour annoncer la taille totale des données avant la première écriture : elle est écrite dans l'en tête du fichier,
+//ce qui permet au décompresseur de réserver la sortie avant de décoder. huff_compresseur_terminer vérifie qu'elle est exacte.
+int huff_compresseur_taille_totale(huff_compresseur *c, uint64_t taille)
+{
+	if (c->position != 0 || c->lus > 0 || c->partiel > 0)
+	{
+		return HUFF_ERREUR_PARAMETRE; //des données ont déjà été passées
+	}
+	c->taille_annoncee = taille;
+	return HUFF_OK;
+}
+
+//fonction pour passer des données compressées à la fonction d'écriture de l'appelant, en mesurant l'écriture
+static int ecrire_compresseur(huff_compresseur *c, const void *p, size_t n)
+{
+	huff_stats *st = c->o.stats != NULL ? &c->stats : NULL;
+	chrono t;
+	demarrer_chrono(&t, st);
+	int r = c->ecrire(c->ctx, p, n);
+	mesurer_phase(&t, st, HUFF_PHASE_ECRITURE);
+	c->stats.octets_sortie += n;
+	c->stats.ecritures++;
+	return r;
+}
+
+//fonction pour écrire l'en tête du fichier avant le premier bloc : magic, version du format et taille annoncée
+static int ecrire_en_tete_fichier(huff_compresseur *c)
+{
+	if (c->position == 0)
+	{
+		uint8_t en_tete[TAILLE_EN_TETE_FICHIER];
+		ecrire_u32(en_tete, MAGIC_FICHIER);
+		en_tete[4] = VERSION_FORMAT;
+		ecrire_u64(en_tete + 5, c->taille_annoncee);
+		if (ecrire_compresseur(c, en_tete, TAILLE_EN_TETE_FICHIER) != 0)
+		{
+			return HUFF_ERREUR_ECRITURE;
+		}
+		c->position = TAILLE_EN_TETE_FICHIER;
+	}
+	return HUFF_OK;
+}
+
+//fonction pour écrire le plus ancien bloc dès qu'il est prêt et l'ajouter à l'index, ce qui libère son emplacement
+//après une erreur les blocs sont seulement libérés. Un bloc sans résultat (allocation échouée) donne HUFF_ERREUR_MEMOIRE.
+static void ecrire_plus_ancien(huff_compresseur *c)
+{
+	emplacement *b = &c->emplacements[c->ecrits % c->fenetre];
+	pthread_mutex_lock(&c->verrou);
+	while (!b->pret)
+	{
+		pthread_cond_wait(&c->bloc_pret, &c->verrou);
+	}
+	pthread_mutex_unlock(&c->verrou);
+	
+	if (c->erreur == HUFF_OK && b->resultat == NULL)
+	{
+		c->erreur = HUFF_ERREUR_MEMOIRE;
+	}
+	if (c->erreur == HUFF_OK)
+	{
+		c->erreur = ecrire_en_tete_fichier(c);
+	}
+	if (c->erreur == HUFF_OK && ecrire_compresseur(c, b->resultat, b->taille_resultat) != 0)
+	{
+		c->erreur = HUFF_ERREUR_ECRITURE;
+	}
+	if (c->erreur == HUFF_OK)
+	{
+    		if (c->ecrits == c->capacite_index)
+    		{
+    			uint8_t *index = realloc(c->index, 2 * c->capacite_index * TAILLE_ENTREE_INDEX + TAILLE_PIED);
+    			if (index == NULL)
+    			{
+    				c->erreur = HUFF_ERREUR_MEMOIRE; //c->index reste valide, il est libéré avec le compresseur
+    			}
+    			else
+    			{
+    				c->index = index;
+    				c->capacite_index *= 2;
+    			}
+    		}
+	}
+	if (c->erreur == HUFF_OK)
+	{
+    		uint8_t *entree_index = c->index + c->ecrits * TAILLE_ENTREE_INDEX;
+    		ecrire_u64(entree_index, c->position);
+    		ecrire_u32(entree_index + 8, (uint32_t)b->taille_resultat);
+    		ecrire_u32(entree_index + 12, (uint32_t)b->taille);
+    		c->position += b->taille_resultat;
+    		c->taille_totale += b->taille;
+    		c->stats.octets_entree += b->taille;
+    		c->stats.blocs++;
+	}
+	free(b->resultat);
+	
+	pthread_mutex_lock(&c->verrou);
+	b->resultat = NULL;
+	b->pret = 0;
+	c->ecrits++;
+	pthread_mutex_unlock(&c->verrou);
+}
+
+//fonction pour arrêter les threads de compression : ils terminent d'abord les blocs déjà remplis
+static void arreter_threads(huff_compresseur *c)
+{
+	if (c->threads == NULL)
+	{
+		return;
+	}
+	pthread_mutex_lock(&c->verrou);
+	c->fin_entree = 1;
+	pthread_cond_broadcast(&c->bloc_lu);
+	pthread_mutex_unlock(&c->verrou);
+	for (int k = 0; k < c->o.nb_threads; k++)
+	{
+		pthread_join(c->threads[k], NULL);
+	}
+	free(c->threads);
+	c->threads = NULL;
+}
+
+//fonction pour créer un compresseur en flux, elle renvoie NULL si les options sont invalides ou si une allocation échoue.
+//Si des threads ne peuvent pas être créés, les blocs sont compressés par ceux qui l'ont été, ou dans le thread appelant.
+huff_compresseur* huff_compresseur_creer(const huff_options *o, huff_ecrire ecrire, void *ctx)
+{
+	if (!options_valides(o))
+	{
+		return NULL;
+	}
+	huff_compresseur *c = calloc(1, sizeof(huff_compresseur));
+	if (c == NULL)
+	{
+		return NULL;
+	}
+	c->o = *o;
+	c->ecrire = ecrire;
+	c->ctx = ctx;
+	c->fenetre = 2 * o->nb_threads;
+	c->taille_annoncee = HUFF_TAILLE_INCONNUE;
+	c->emplacements = calloc(c->fenetre, sizeof(emplacement));
+	c->capacite_index = 64;
+	c->index = malloc(c->capacite_index * TAILLE_ENTREE_INDEX + TAILLE_PIED);
+	if (c->emplacements == NULL || c->index == NULL)
+	{
+		free(c->emplacements);
+		free(c->index);
+		free(c);
+		return NULL;
+	}
+	pthread_mutex_init(&c->verrou, NULL);
+	pthread_cond_init(&c->bloc_lu, NULL);
+	pthread_cond_init(&c->bloc_pret, NULL);
+	pthread_cond_init(&c->table_choisie, NULL);
+	
+	if (o->nb_threads > 1) //avec un seul thread on compresse dans le thread appelant
+	{
+		c->threads = malloc(o->nb_threads * sizeof(pthread_t));
+		int k = 0;
+		while (c->threads != NULL && k < o->nb_threads && pthread_create(&c->threads[k], NULL, thread_compression, c) == 0)
+		{
+			k++;
+		}
+		c->o.nb_threads = k > 0 ? k : 1; //arreter_threads attend ceux qui ont été créés
+		if (k == 0)
+		{
+			free(c->threads);
+			c->threads = NULL;
+		}
+	}
+	return c;
+}
+
+//fonction commune aux deux fonctions d'écriture : les octets sont copiés dans le bloc en cours de remplissage,
+//sauf les blocs complets de p quand sans_copie vaut 1
+static int ecrire_blocs(huff_compresseur *c, const uint8_t *p, size_t n, int sans_copie)
+{
+	size_t taille_bloc = c->o.taille_bloc;
+	while (n > 0 && c->erreur == HUFF_OK)
+	{
+		if (c->partiel == 0 && c->lus - c->ecrits == c->fenetre)
+		{
+			ecrire_plus_ancien(c); //la fenêtre est pleine : on attend le plus ancien bloc
+			continue;
+		}
+		
+		emplacement *b = &c->emplacements[c->lus % c->fenetre];
+		if (sans_copie && c->partiel == 0 && n >= taille_bloc)
+		{
+			publier(c, b, p, taille_bloc);
+			p += taille_bloc;
+			n -= taille_bloc;
+			continue;
+		}
+		
+		if (b->tampon == NULL)
+		{
+			b->tampon = malloc(taille_bloc);
+			if (b->tampon == NULL)
+			{
+				c->erreur = HUFF_ERREUR_MEMOIRE;
+				break;
+			}
+		}
+		size_t k = n < taille_bloc - c->partiel ? n : taille_bloc - c->partiel;
+		memcpy(b->tampon + c->partiel, p, k);
+		c->partiel += k;
+		p += k;
+		n -= k;
+		if (c->partiel == taille_bloc)
+		{
+			publier(c, b, b->tampon, taille_bloc);
+			c->partiel = 0;
+		}
+	}
+	return c->erreur;
+}
+
+//fonction pour passer un morceau des données à compresser, il est copié
+int huff_compresseur_ecrire(huff_compresseur *c, const void *p, size_t n)
+{
+	return ecrire_blocs(c, p, n, 0);
+}
+
+//fonction pour passer un morceau des données à compresser sans le copier, il doit rester valide jusqu'à la fin
+int huff_compresseur_ecrire_sans_copie(huff_compresseur *c, const void *p, size_t n)
+{
+	return ecrire_blocs(c, p, n, 1);
+}
+
+//fonction pour terminer la compression : le dernier bloc incomplet est compressé, tous les blocs sont écrits,
+//puis le marqueur de fin, l'index et le pied qui donne le nombre de blocs et la position de l'index
+int huff_compresseur_terminer(huff_compresseur *c)
+{
+	if (c->partiel > 0 && c->erreur == HUFF_OK)
+	{
+		emplacement *b = &c->emplacements[c->lus % c->fenetre];
+		publier(c, b, b->tampon, c->partiel);
+		c->partiel = 0;
+	}
+	while (c->ecrits < c->lus)
+	{
+		ecrire_plus_ancien(c);
+	}
+	arreter_threads(c);
+	if (c->erreur != HUFF_OK)
+	{
+		return c->erreur;
+	}
+	if (c->ecrits > UINT32_MAX || (c->taille_annoncee != HUFF_TAILLE_INCONNUE && c->taille_annoncee != c->taille_totale))
+	{
+		return c->erreur = HUFF_ERREUR_PARAMETRE; //trop de blocs (il faut des blocs plus grands), ou taille annoncée inexacte
+	}
+	c->erreur = ecrire_en_tete_fichier(c); //données vides : l'en tête n'a pas encore été écrit
+	if (c->erreur != HUFF_OK)
+	{
+		return c->erreur;
+	}
+	
+	uint8_t marqueur = BLOC_FIN;
+	size_t taille_index = c->ecrits * TAILLE_ENTREE_INDEX;
+	ecrire_u32(c->index + taille_index, (uint32_t)c->ecrits);
+	ecrire_u64(c->index + taille_index + 4, c->position + 1);
+	ecrire_u64(c->index + taille_index + 12, c->taille_totale);
+	if (ecrire_compresseur(c, &marqueur, 1) != 0 || ecrire_compresseur(c, c->index, taille_index + TAILLE_PIED) != 0)
+	{
+		c->erreur = HUFF_ERREUR_ECRITURE;
+	}
+	if (c->erreur == HUFF_OK && c->o.stats != NULL)
+	{
+		ajouter_stats(c->o.stats, &c->stats); //les mesures des blocs y sont déjà
+	}
+	return c->erreur;
+}
+
+//fonction pour libérer un compresseur, terminé ou non
+void huff_compresseur_liberer(huff_compresseur *c)
+{
+	if (c == NULL)
+	{
+		return;
+	}
+	arreter_threads(c);
+	pthread_mutex_destroy(&c->verrou);
+	pthread_cond_destroy(&c->bloc_lu);
+	pthread_cond_destroy(&c->bloc_pret);
+	pthread_cond_destroy(&c->table_choisie);
+	for (uint32_t k = 0; k < c->fenetre; k++)
+	{
+		free(c->emplacements[k].resultat);
+		free(c->emplacements[k].tampon);
+	}
+	free(c->emplacements);
+	free(c->index);
+	free(c);
+}
+
+//structure et fonction d'écriture dans le tampon de sortie de huff_compresser
+typedef struct {
+	uint8_t *dst;
+	size_t capacite;
+	size_t taille;
+} sortie_memoire;
+
+static int ecrire_memoire(void *ctx, const void *p, size_t n)
+{
+	sortie_memoire *s = ctx;
+	if (n > s->capacite - s->taille)
+	{
+		return -1;
+	}
+	memcpy(s->dst + s->taille, p, n);
+	s->taille += n;
+	return 0;
+}
+
+//fonction qui renvoie la taille maximale des données compressées : chaque bloc a son en tête et sa table,
+//chaque caractère prend au plus lg_max bits, puis le marqueur, l'index et le pied
+size_t huff_taille_max(size_t taille, const huff_options *o)
+{
+	size_t nb_blocs = (taille + o->taille_bloc - 1) / o->taille_bloc;
+	size_t lg_max = o->dictionnaire != NULL && o->dictionnaire->lg_max > o->lg_max ? o->dictionnaire->lg_max : (size_t)o->lg_max;
+	if (lg_max < 8)
+	{
+		lg_max = 8; //un bloc stocké brut garde ses 8 bits par caractère
+	}
+	return TAILLE_EN_TETE_FICHIER + nb_blocs * (TAILLE_EN_TETE_BLOC + EN_TETE_TAILLE_MAX + 1 + TAILLE_ENTREE_INDEX) + (taille * lg_max + 7) / 8 + 1 + TAILLE_PIED;
+}
+
+//fonction pour compresser une zone en mémoire dans dst : les blocs sont compressés sans copie de src
+int huff_compresser(const void *src, size_t taille, void *dst, size_t *taille_dst, const huff_options *o)
+{
+	sortie_memoire s = {dst, *taille_dst, 0};
+	if (!options_valides(o))
+	{
+		return HUFF_ERREUR_PARAMETRE;
+	}
+	if (o->dictionnaire != NULL && taille > 0 && taille <= o->taille_bloc) //message court, écrit dans un tampon si dst est juste
+	{
+		uint64_t tab[256];
+		size_t t = huff_taille_max(taille, o);
+		uint8_t *message = *taille_dst >= t ? dst : malloc(t);
+		if (message == NULL)
+		{
+			return HUFF_ERREUR_MEMOIRE;
+		}
+		t = ecrire_message(message, src, taille, o, tab);
+		int r = t <= *taille_dst ? HUFF_OK : HUFF_ERREUR_PLACE;
+		if (message != dst)
+		{
+			if (r == HUFF_OK)
+			{
+				memcpy(dst, message, t);
+			}
+			free(message);
+		}
+		*taille_dst = r == HUFF_OK ? t : 0;
+		return r;
+	}
+	huff_compresseur *c = huff_compresseur_creer(o, ecrire_memoire, &s);
+	if (c == NULL)
+	{
+		return HUFF_ERREUR_MEMOIRE;
+	}
+	huff_compresseur_taille_totale(c, taille);
+	int r = huff_compresseur_ecrire_sans_copie(c, src, taille);
+	if (r == HUFF_OK)
+	{
+		r = huff_compresseur_terminer(c);
+	}
+	huff_compresseur_liberer(c);
+	if (r == HUFF_ERREUR_ECRITURE) //la seule écriture qui peut échouer est celle qui dépasse dst
+	{
+		r = HUFF_ERREUR_PLACE;
+	}
+	*taille_dst = s.taille;
+	return r;
+}
+
+//fonction qui dit si des données de cette taille passent par huff_compresser_petit : le modèle d'ordre 1, les plages et les codes
+//longs ne passent pas par huff_contexte, sauf avec un dictionnaire qui les remplace
+int huff_petit_possible(size_t taille, const huff_options *o)
+{
+	return taille <= HUFF_PETIT_MAX && taille <= o->taille_bloc && ((o->ordre == 0 && o->plages == 0) || o->dictionnaire != NULL)
+		&& o->lg_max <= HUFF_LONGUEUR_CONTEXTE;
+}
+
+//fonction pour compresser une zone en mémoire dans dst en un seul bloc, sans allocation ni thread : les apparitions, les longueurs
+//et les codes sont dans le contexte et le bloc est codé directement dans dst. Le codage est choisi comme pour le premier bloc
+//de huff_compresser, qui donne le même résultat quand les données tiennent dans un bloc et que ses codes ont au plus 15 bits.
+int huff_compresser_petit(huff_contexte *ctx, const void *src, size_t taille, void *dst, size_t *taille_dst, const huff_options *o)
+{
+	_Static_assert(sizeof(contexte_petit) <= sizeof(huff_contexte), "HUFF_TAILLE_CONTEXTE est trop petit");
+	contexte_petit *cp = (contexte_petit *)ctx->prive;
+	const uint8_t *donnees = src;
+	uint8_t *sortie = dst;
+	if (!options_valides(o) || taille > o->taille_bloc)
+	{
+		return HUFF_ERREUR_PARAMETRE;
+	}
+	if (*taille_dst < huff_taille_max(taille, o))
+	{
+		return HUFF_ERREUR_PLACE; //le bloc est codé sans vérifier la place, comme dans le tampon alloué par ecrire_bloc
+	}
+	if (taille > 0 && o->dictionnaire != NULL)
+	{
+		*taille_dst = ecrire_message(sortie, donnees, taille, o, cp->apparitions);
+		return HUFF_OK;
+	}
+	huff_stats mesures = {0};
+	huff_stats *st = o->stats != NULL ? &mesures : NULL;
+	chrono t;
+	demarrer_chrono(&t, st);
+	
+	ecrire_u32(sortie, MAGIC_FICHIER);
+	sortie[4] = VERSION_FORMAT;
+	ecrire_u64(sortie + 5, taille);
+	size_t position = TAILLE_EN_TETE_FICHIER;
+	size_t taille_bloc = 0;
+	int nb_flux = nb_flux_bloc(o, taille);
+	if (taille > 0)
+	{
+		int lg_max = o->lg_max < LONGUEUR_FIXE_MAX ? o->lg_max : LONGUEUR_FIXE_MAX; //la table de décodage doit tenir dans un contexte
+		int type = BLOC_TABLE;
+		uint64_t taille_prevue;
+		if (bloc_incompressible(donnees, taille, lg_max))
+		{
+			type = BLOC_BRUT;
+		}
+		else
+		{
+			apparitions(donnees, taille, cp->apparitions);
+			if (cp->apparitions[donnees[0]] == taille)
+			{
+				type = BLOC_CONSTANT;
+			}
+		}
+		mesurer_phase(&t, st, HUFF_PHASE_HISTOGRAMME);
+		if (type == BLOC_TABLE)
+		{
+			type = choisir_codage(NULL, lg_max, cp->apparitions, taille, nb_flux == 4 ? FLUX_SURCOUT : 0, BLOC_TABLE, UINT64_MAX, cp->longueurs, &taille_prevue);
+		}
+		mesurer_phase(&t, st, HUFF_PHASE_ARBRE);
+		taille_bloc = coder_bloc(sortie + position, type, donnees, taille, cp->longueurs, cp->codes, nb_flux);
+		mesurer_phase(&t, st, HUFF_PHASE_CODAGE);
+		if (st != NULL && type == BLOC_TABLE)
+		{
+			compter_caracteres(st, cp->apparitions, cp->longueurs, taille);
+		}
+	}
+	
+	//marqueur de fin, index d'au plus un bloc et pied, comme à la fin de huff_compresseur_terminer
+	uint32_t nb_blocs = taille > 0;
+	position += taille_bloc;
+	sortie[position++] = BLOC_FIN;
+	size_t position_index = position;
+	if (nb_blocs > 0)
+	{
+		ecrire_u64(sortie + position, TAILLE_EN_TETE_FICHIER);
+		ecrire_u32(sortie + position + 8, (uint32_t)taille_bloc);
+		ecrire_u32(sortie + position + 12, (uint32_t)taille);
+		position += TAILLE_ENTREE_INDEX;
+	}
+	ecrire_u32(sortie + position, nb_blocs);
+	ecrire_u64(sortie + position + 4, position_index);
+	ecrire_u64(sortie + position + 12, taille);
+	*taille_dst = position + TAILLE_PIED;
+	if (st != NULL)
+	{
+		st->octets_entree += taille;
+		st->octets_sortie += *taille_dst;
+		st->blocs += nb_blocs;
+		ajouter_stats(o->stats, st);
+	}
+	return HUFF_OK;
+}
+
+//fonction pour lire l'en tête du fichier au début des données compressées : il suffit d'en avoir les premiers octets.
+//*taille_originale reçoit la taille des données d'origine, ou HUFF_TAILLE_INCONNUE si elle n'était pas connue à la compression.
+//Pour un message court, c'est la taille d'origine de son bloc, dont l'en tête commence après le magic.
+int huff_lire_en_tete(const void *src, size_t taille, uint64_t *taille_originale)
+{
+	const uint8_t *p = src;
+	if (taille >= TAILLE_EN_TETE_FICHIER && lire_u32(p) == MAGIC_MESSAGE)
+	{
+		*taille_originale = lire_u32(p + TAILLE_EN_TETE_MESSAGE + 1);
+		return HUFF_OK;
+	}
+	if (taille < TAILLE_EN_TETE_FICHIER || lire_u32(p) != MAGIC_FICHIER)
+	{
+		return HUFF_ERREUR_DONNEES;
+	}
+	if (p[4] != VERSION_FORMAT)
+	{
+		return HUFF_ERREUR_VERSION;
+	}
+	*taille_originale = lire_u64(p + 5);
+	return HUFF_OK;
+}
+
+//fonction pour lire le pied et l'index des blocs à la fin des données compressées, après avoir vérifié l'en tête du fichier
+//la position de chaque bloc dans les données décompressées est la somme des tailles d'origine des blocs précédents.
+//Un message court n'a ni index ni pied : son index d'un bloc est construit d'après l'en tête du bloc.
+static int lire_index(const uint8_t *src, size_t taille, bloc_index **blocs, uint32_t *nb_blocs, uint64_t *taille_sortie)
+{
+    	uint64_t taille_annoncee;
+    	int r = huff_lire_en_tete(src, taille, &taille_annoncee);
+    	if (r != HUFF_OK)
+    	{
+    		return r;
+    	}
+    	if (lire_u32(src) == MAGIC_MESSAGE)
+    	{
+    		size_t taille_bloc = taille_message(src, taille);
+    		if (taille_bloc == 0)
+    		{
+			return HUFF_ERREUR_DONNEES;
+    		}
+    		*blocs = malloc(sizeof(bloc_index));
+    		if (*blocs == NULL)
+    		{
+    			return HUFF_ERREUR_MEMOIRE;
+    		}
+    		bloc_index *b = *blocs;
+    		b->position = TAILLE_EN_TETE_MESSAGE;
+    		b->taille = taille_bloc;
+    		b->taille_originale = taille_annoncee;
+    		b->position_sortie = 0;
+    		b->table = TYPE_BLOC(src[TAILLE_EN_TETE_MESSAGE]) == BLOC_TABLE ? 0 : UINT32_MAX;
+    		if (TYPE_BLOC(src[TAILLE_EN_TETE_MESSAGE]) == BLOC_REUTILISE) //aucune table avant le seul bloc
+    		{
+    			free(*blocs);
+			return HUFF_ERREUR_DONNEES;
+    		}
+    		*nb_blocs = 1;
+    		*taille_sortie = taille_annoncee;
+    		return HUFF_OK;
+    	}
+    	if (taille < TAILLE_EN_TETE_FICHIER + 1 + TAILLE_PIED)
+    	{
+		return HUFF_ERREUR_DONNEES;
+    	}
+    	const uint8_t *pied = src + taille - TAILLE_PIED;
+    	*nb_blocs = lire_u32(pied);
+    	uint64_t position_index = lire_u64(pied + 4);
+    	uint64_t taille_pied = lire_u64(pied + 12);
+    	uint64_t taille_index = (uint64_t)*nb_blocs * TAILLE_ENTREE_INDEX;
+    	if (position_index > taille || position_index < TAILLE_EN_TETE_FICHIER + 1 || position_index + taille_index + TAILLE_PIED != taille
+    		|| (taille_annoncee != HUFF_TAILLE_INCONNUE && taille_annoncee != taille_pied))
+    	{
+		return HUFF_ERREUR_DONNEES;
+    	}
+    	
+    	const uint8_t *index = src + position_index;
+    	*blocs = malloc(((size_t)*nb_blocs + 1) * sizeof(bloc_index));
+    	if (*blocs == NULL)
+    	{
+    		return HUFF_ERREUR_MEMOIRE;
+    	}
+    	*taille_sortie = 0;
+    	uint32_t derniere_table = UINT32_MAX;
+    	for (uint32_t i = 0; i < *nb_blocs; i++)
+    	{
+    		bloc_index *b = &(*blocs)[i];
+    		b->position = lire_u64(index + (size_t)i * TAILLE_ENTREE_INDEX);
+    		b->taille = lire_u32(index + (size_t)i * TAILLE_ENTREE_INDEX + 8);
+    		b->taille_originale = lire_u32(index + (size_t)i * TAILLE_ENTREE_INDEX + 12);
+    		b->position_sortie = *taille_sortie;
+    		*taille_sortie += b->taille_originale;
+    		if (b->position < TAILLE_EN_TETE_FICHIER || b->position >= position_index || b->taille >= position_index - b->position) //le dernier octet avant l'index est le marqueur de fin
+    		{
+    			free(*blocs);
+			return HUFF_ERREUR_DONNEES;
+    		}
+    		uint8_t type = TYPE_BLOC(src[b->position]); //un bloc BLOC_REUTILISE est décodé avec la table du dernier bloc BLOC_TABLE qui le précède
+    		if (type == BLOC_TABLE)
+    		{
+    			derniere_table = i;
+    		}
+    		b->table = type == BLOC_TABLE || type == BLOC_REUTILISE ? derniere_table : UINT32_MAX;
+    		if (type == BLOC_REUTILISE && derniere_table == UINT32_MAX)
+    		{
+    			free(*blocs);
+			return HUFF_ERREUR_DONNEES;
+    		}
+    	}
+    	if (*taille_sortie != taille_pied) //l'index et le pied ne concordent pas
+    	{
+    		free(*blocs);
+		return HUFF_ERREUR_DONNEES;
+    	}
+    	return HUFF_OK;
+}
+
+//fonction exécutée par chaque thread de décompression : on prend le prochain bloc tant qu'il en reste
+static void* thread_decompression(void *arg)
+{
+	travail_decompression *w = arg;
+    	uint8_t *tampon = NULL; //tampon réutilisé d'un bloc à l'autre quand les blocs sont passés à ecrire
+    	size_t capacite_tampon = 0;
+    	table_courante tc = {{0}, NULL, UINT32_MAX, NULL}; //table gardée d'un bloc à l'autre pour les blocs qui la réutilisent
+    	huff_stats mesures = {0};
+    	huff_stats *st = w->o->stats != NULL ? &mesures : NULL; //les mesures du thread sont ajoutées à la fin
+    	
+	for (;;)
+	{
+		pthread_mutex_lock(&w->verrou);
+		uint32_t i = w->erreur == HUFF_OK ? w->suivant++ : w->nb_blocs;
+		pthread_mutex_unlock(&w->verrou);
+		if (i >= w->nb_blocs)
+		{
+			break;
+		}
+		const bloc_index *b = &w->blocs[i];
+		
+		int r = HUFF_OK;
+		if (w->dst != NULL) //chaque bloc est décodé directement à sa position
+		{
+    			r = decoder_bloc_index(w->src, w->blocs, i, w->dst + b->position_sortie, b->taille_originale, w->o, &tc, st);
+		}
+		else
+		{
+    			if (b->taille_originale > capacite_tampon)
+    			{
+    				uint8_t *t = realloc(tampon, b->taille_originale);
+    				if (t != NULL)
+    				{
+    					tampon = t;
+    					capacite_tampon = b->taille_originale;
+    				}
+    			}
+    			r = b->taille_originale > capacite_tampon ? HUFF_ERREUR_MEMOIRE
+    				: decoder_bloc_index(w->src, w->blocs, i, tampon, b->taille_originale, w->o, &tc, st);
+    			chrono t;
+    			demarrer_chrono(&t, st);
+    			if (r == HUFF_OK && w->ecrire(w->ctx, tampon, b->taille_originale, b->position_sortie) != 0)
+    			{
+    				r = HUFF_ERREUR_ECRITURE;
+    			}
+    			mesurer_phase(&t, st, HUFF_PHASE_ECRITURE);
+    			mesures.ecritures++;
+		}
+		
+		if (r != HUFF_OK)
+		{
+			pthread_mutex_lock(&w->verrou);
+			if (w->erreur == HUFF_OK)
+			{
+				w->erreur = r;
+			}
+			pthread_mutex_unlock(&w->verrou);
+		}
+	}
+	
+	free(tampon);
+	free_table_courante(&tc);
+	if (st != NULL)
+	{
+		ajouter_stats(w->o->stats, st);
+	}
+	return NULL;
+}
+
+//fonction commune aux décompressions d'une zone en mémoire : on lit l'index puis les blocs sont décodés en parallèle,
+//dans dst si dst n'est pas NULL, sinon ils sont passés à ecrire
+static int decompresser_blocs(const uint8_t *src, size_t taille, uint8_t *dst, size_t taille_dst, huff_ecrire_a ecrire, void *ctx, const huff_options *o)
+{
+	travail_decompression w;
+	uint64_t taille_sortie;
+	int r = lire_index(src, taille, (bloc_index **)&w.blocs, &w.nb_blocs, &taille_sortie);
+	if (r != HUFF_OK)
+	{
+		return r;
+	}
+	if (dst != NULL && taille_sortie > taille_dst)
+	{
+		free((bloc_index *)w.blocs);
+		return HUFF_ERREUR_PLACE;
+	}
+	
+	w.src = src;
+	w.suivant = 0;
+	w.dst = dst;
+	w.ecrire = ecrire;
+	w.ctx = ctx;
+	w.o = o;
+	w.erreur = HUFF_OK;
+	pthread_mutex_init(&w.verrou, NULL);
+	
+	int nb_threads = o->nb_threads;
+	if ((uint32_t)nb_threads > w.nb_blocs) //inutile d'avoir plus de threads que de blocs
+	{
+		nb_threads = w.nb_blocs > 0 ? (int)w.nb_blocs : 1;
+	}
+	//avec un seul thread on décode dans le thread appelant, qui prend aussi le travail des threads qui n'ont pas pu être créés
+	pthread_t *threads = nb_threads > 1 ? malloc(nb_threads * sizeof(pthread_t)) : NULL;
+	int crees = 0;
+	while (threads != NULL && crees < nb_threads && pthread_create(&threads[crees], NULL, thread_decompression, &w) == 0)
+	{
+		crees++;
+	}
+	if (crees < nb_threads)
+	{
+		thread_decompression(&w);
+	}
+	for (int k = 0; k < crees; k++)
+	{
+		pthread_join(threads[k], NULL);
+	}
+	free(threads);
+	
+	pthread_mutex_destroy(&w.verrou);
+	free((bloc_index *)w.blocs);
+	return w.erreur;
+}
+
+//fonction pour lire la taille des données d'origine dans l'index des blocs
+int huff_taille_originale(const void *src, size_t taille, uint64_t *taille_originale)
+{
+	bloc_index *blocs;
+	uint32_t nb_blocs;
+	int r = lire_index(src, taille, &blocs, &nb_blocs, taille_originale);
+	if (r == HUFF_OK)
+	{
+		free(blocs);
+	}
+	return r;
+}
+
+//fonction pour décompresser une zone en mémoire dans dst, *taille_dst contient la place disponible dans dst
+//et reçoit la taille des données d'origine
+int huff_decompresser(const void *src, size_t taille, void *dst, size_t *taille_dst, const huff_options *o)
+{
+	uint64_t taille_originale;
+	int r = huff_taille_originale(src, taille, &taille_originale);
+	if (r != HUFF_OK)
+	{
+		return r;
+	}
+	r = decompresser_blocs(src, taille, dst, *taille_dst, NULL, NULL, o);
+	if (r == HUFF_OK)
+	{
+		*taille_dst = taille_originale;
+	}
+	return r;
+}
+
+//fonction pour décompresser une zone en mémoire en passant chaque bloc décodé à ecrire avec sa position
+int huff_decompresser_vers(const void *src, size_t taille, huff_ecrire_a ecrire, void *ctx, const huff_options *o)
+{
+	return decompresser_blocs(src, taille, NULL, 0, ecrire, ctx, o);
+}
+
+//fonction pour décompresser seulement *longueur octets des données d'origine à partir de la position debut :
+//on ne décode que les blocs qui recouvrent l'intervalle, et le dernier seulement jusqu'à la fin de l'intervalle
+int huff_decompresser_intervalle(const void *src, size_t taille, uint64_t debut, size_t *longueur, void *dst, const huff_options *o)
+{
+	bloc_index *blocs;
+	uint32_t nb_blocs;
+	uint64_t taille_sortie;
+	int r = lire_index(src, taille, &blocs, &nb_blocs, &taille_sortie);
+	if (r != HUFF_OK)
+	{
+		return r;
+	}
+	if (debut > taille_sortie) //l'intervalle est ramené à la taille des données d'origine
+	{
+		debut = taille_sortie;
+	}
+	if (*longueur > taille_sortie - debut)
+	{
+		*longueur = taille_sortie - debut;
+	}
+	
+	uint64_t fin = debut + *longueur;
+	uint32_t g = 0, d = nb_blocs; //recherche dichotomique du premier bloc qui se termine après debut
+	while (g < d)
+	{
+		uint32_t m = g + (d - g) / 2;
+		if (blocs[m].position_sortie + blocs[m].taille_originale <= debut)
+		{
+			g = m + 1;
+		}
+		else
+		{
+			d = m;
+		}
+	}
+	
+	uint8_t *tampon = NULL;
+	table_courante tc = {{0}, NULL, UINT32_MAX, NULL};
+	huff_stats mesures = {0};
+	huff_stats *st = o->stats != NULL ? &mesures : NULL;
+	for (uint32_t i = g; i < nb_blocs && blocs[i].position_sortie < fin && r == HUFF_OK; i++)
+	{
+		const bloc_index *b = &blocs[i];
+		size_t n = fin - b->position_sortie < b->taille_originale ? fin - b->position_sortie : b->taille_originale;
+		if (b->position_sortie >= debut) //le bloc commence dans l'intervalle : il est décodé directement dans dst
+		{
+			r = decoder_bloc_index(src, blocs, i, (uint8_t *)dst + (b->position_sortie - debut), n, o, &tc, st);
+			continue;
+		}
+		
+		//on ne garde que la partie du premier bloc comprise dans l'intervalle
+		size_t saut = debut - b->position_sortie;
+		tampon = malloc(n);
+		if (tampon == NULL)
+		{
+			r = HUFF_ERREUR_MEMOIRE;
+			break;
+		}
+		r = decoder_bloc_index(src, blocs, i, tampon, n, o, &tc, st);
+		if (r == HUFF_OK)
+		{
+			memcpy(dst, tampon + saut, n - saut);
+		}
+		free(tampon);
+	}
+	
+	free_table_courante(&tc);
+	free(blocs);
+	if (st != NULL)
+	{
+		ajouter_stats(o->stats, st);
+	}
+	return r;
+}
+
+//fonction pour décompresser une zone en mémoire dans dst sans allocation ni thread : les blocs sont lus à la suite jusqu'au
+//marqueur de fin, comme en flux, et décodés directement dans dst avec la table de décodage du contexte, réutilisée d'un bloc à l'autre.
+//Le pied est vérifié, l'index n'est pas lu. *taille_dst contient la place disponible dans dst et reçoit la taille des données d'origine.
+int huff_decompresser_petit(huff_contexte *ctx, const void *src, size_t taille, void *dst, size_t *taille_dst, const huff_options *o)
+{
+	contexte_petit *cp = (contexte_petit *)ctx->prive;
+	const uint8_t *p = src;
+	uint8_t *sortie = dst;
+	uint64_t taille_annoncee;
+	int r = huff_lire_en_tete(src, taille, &taille_annoncee);
+	if (r != HUFF_OK)
+	{
+		return r;
+	}
+	if (taille_annoncee != HUFF_TAILLE_INCONNUE && taille_annoncee > *taille_dst)
+	{
+		return HUFF_ERREUR_PLACE;
+	}
+	
+	cp->table.entrees = cp->entrees;
+	cp->table.capacite = TABLE_FIXE_CAPACITE;
+	cp->tc.table = NULL;
+	cp->tc.bloc = UINT32_MAX;
+	cp->tc.fixe = &cp->table;
+	huff_stats mesures = {0};
+	huff_stats *st = o->stats != NULL ? &mesures : NULL;
+	int message = lire_u32(p) == MAGIC_MESSAGE; //un seul bloc, sans marqueur de fin ni pied
+	size_t position = message ? TAILLE_EN_TETE_MESSAGE : TAILLE_EN_TETE_FICHIER;
+	size_t decodes = 0;
+	uint32_t nb_blocs = 0;
+	while (r == HUFF_OK && !(message && nb_blocs == 1))
+	{
+		if (position >= taille)
+		{
+			r = HUFF_ERREUR_DONNEES; //marqueur de fin absent
+			break;
+		}
+		if (!message && p[position] == BLOC_FIN)
+		{
+			break;
+		}
+		size_t taille_bloc = taille - position >= TAILLE_EN_TETE_BLOC ? taille_bloc_flux(p + position) : 0;
+		if (taille_bloc == 0 || taille_bloc > taille - position)
+		{
+			r = HUFF_ERREUR_DONNEES;
+			break;
+		}
+		size_t taille_originale = lire_u32(p + position + 1);
+		if (taille_originale > *taille_dst - decodes)
+		{
+			r = HUFF_ERREUR_PLACE;
+			break;
+		}
+		r = decoder_bloc(p + position, taille_bloc, sortie + decodes, taille_originale, taille_originale, o, &cp->tc, st);
+		position += taille_bloc;
+		decodes += taille_originale;
+		nb_blocs++;
+	}
+	
+	//pied : même nombre de blocs et même taille d'origine que les blocs lus, un message court s'arrête à la fin de son bloc
+	if (r == HUFF_OK && message && position != taille)
+	{
+		r = HUFF_ERREUR_DONNEES;
+	}
+	else if (r == HUFF_OK && !message && (taille - position - 1 != (size_t)nb_blocs * TAILLE_ENTREE_INDEX + TAILLE_PIED || lire_u32(p + taille - TAILLE_PIED) != nb_blocs
+		|| lire_u64(p + taille - TAILLE_PIED + 4) != position + 1 || lire_u64(p + taille - TAILLE_PIED + 12) != decodes
+		|| (taille_annoncee != HUFF_TAILLE_INCONNUE && taille_annoncee != decodes)))
+	{
+		r = HUFF_ERREUR_DONNEES;
+	}
+	if (st != NULL)
+	{
+		ajouter_stats(o->stats, st);
+	}
+	if (r == HUFF_OK)
+	{
+		*taille_dst = decodes;
+	}
+	return r;
+}
+
+//fonction pour créer un décompresseur en flux, elle renvoie NULL si une allocation échoue
+huff_decompresseur* huff_decompresseur_creer(const huff_options *o, huff_ecrire ecrire, void *ctx)
+{
+	huff_decompresseur *d = calloc(1, sizeof(huff_decompresseur));
+	if (d == NULL)
+	{
+		return NULL;
+	}
+	d->o = *o;
+	d->ecrire = ecrire;
+	d->ctx = ctx;
+	d->tc.bloc = UINT32_MAX;
+	d->taille_annoncee = HUFF_TAILLE_INCONNUE;
+	d->capacite_bloc = TAILLE_EN_TETE_BLOC;
+	d->bloc = malloc(d->capacite_bloc);
+	if (d->bloc == NULL)
+	{
+		free(d);
+		return NULL;
+	}
+	return d;
+}
+
+//fonction qui renvoie la taille totale d'un bloc d'après son en tête, ou 0 si l'en tête est incohérent
+static size_t taille_bloc_flux(const uint8_t *en_tete)
+{
+	uint64_t taille_originale = lire_u32(en_tete + 1);
+	uint64_t reste = lire_u32(en_tete + 5);
+	//un bloc ne dépasse pas la taille maximale, ni ses en têtes des longueurs plus 32 bits par caractère
+	if (TYPE_BLOC(en_tete[0]) > BLOC_PLAGES || taille_originale > HUFF_TAILLE_BLOC_MAX || reste > EN_TETE_CONTEXTE_MAX + FLUX_SURCOUT + taille_originale * 4 + 1)
+	{
+		return 0;
+	}
+	return TAILLE_EN_TETE_BLOC + reste;
+}
+
+//fonction pour décoder un bloc complet reçu en flux et passer le résultat à ecrire
+static void decoder_bloc_flux(huff_decompresseur *d, const uint8_t *bloc, size_t taille)
+{
+	size_t taille_originale = lire_u32(bloc + 1);
+	if (taille_originale > d->capacite_tampon)
+	{
+		uint8_t *tampon = realloc(d->tampon, taille_originale);
+		if (tampon == NULL)
+		{
+			d->erreur = HUFF_ERREUR_MEMOIRE;
+			return;
+		}
+		d->tampon = tampon;
+		d->capacite_tampon = taille_originale;
+	}
+	huff_stats mesures = {0};
+	huff_stats *st = d->o.stats != NULL ? &mesures : NULL; //les mesures du bloc sont ajoutées à la fin
+	d->erreur = decoder_bloc(bloc, taille, d->tampon, taille_originale, taille_originale, &d->o, &d->tc, st); //les blocs arrivent dans l'ordre, tc garde la dernière table
+	d->decodes += taille_originale;
+	chrono t;
+	demarrer_chrono(&t, st);
+	if (d->erreur == HUFF_OK && taille_originale > 0)
+	{
+		if (d->ecrire(d->ctx, d->tampon, taille_originale) != 0)
+		{
+			d->erreur = HUFF_ERREUR_ECRITURE;
+		}
+		mesurer_phase(&t, st, HUFF_PHASE_ECRITURE);
+		mesures.ecritures++;
+	}
+	if (st != NULL)
+	{
+		ajouter_stats(d->o.stats, st);
+	}
+}
+
+//fonction pour passer un morceau des données compressées : les blocs sont lus à la suite jusqu'au marqueur de fin
+//et décodés dès qu'ils sont complets, après l'en tête du fichier. Un bloc entièrement contenu dans p est décodé sans copie.
+int huff_decompresseur_ecrire(huff_decompresseur *d, const void *p, size_t n)
+{
+	const uint8_t *q = p;
+	if (d->recus_en_tete < TAILLE_EN_TETE_FICHIER && n > 0 && d->erreur == HUFF_OK)
+	{
+		size_t k = n < TAILLE_EN_TETE_FICHIER - d->recus_en_tete ? n : TAILLE_EN_TETE_FICHIER - d->recus_en_tete;
+		memcpy(d->en_tete + d->recus_en_tete, q, k);
+		d->recus_en_tete += k;
+		q += k;
+		n -= k;
+		if (d->recus_en_tete == TAILLE_EN_TETE_FICHIER)
+		{
+			d->erreur = huff_lire_en_tete(d->en_tete, TAILLE_EN_TETE_FICHIER, &d->taille_annoncee);
+			if (d->erreur == HUFF_OK && lire_u32(d->en_tete) == MAGIC_MESSAGE)
+			{
+				d->message = 1; //les octets reçus après le magic sont le début de l'en tête du bloc
+				d->recus = TAILLE_EN_TETE_FICHIER - TAILLE_EN_TETE_MESSAGE;
+				memcpy(d->bloc, d->en_tete + TAILLE_EN_TETE_MESSAGE, d->recus);
+			}
+		}
+	}
+	while (n > 0 && !d->fin && d->erreur == HUFF_OK)
+	{
+		if (d->recus == 0)
+		{
+			if (q[0] == BLOC_FIN)
+			{
+				d->fin = 1; //l'index et le pied qui suivent ne servent pas en flux
+				if (d->taille_annoncee != HUFF_TAILLE_INCONNUE && d->taille_annoncee != d->decodes)
+				{
+					d->erreur = HUFF_ERREUR_DONNEES;
+				}
+				break;
+			}
+			size_t taille = n >= TAILLE_EN_TETE_BLOC ? taille_bloc_flux(q) : 0;
+			if (taille > 0 && n >= taille)
+			{
+				decoder_bloc_flux(d, q, taille);
+				q += taille;
+				n -= taille;
+				continue;
+			}
+		}
+		
+		if (d->recus < TAILLE_EN_TETE_BLOC)
+		{
+			size_t k = n < TAILLE_EN_TETE_BLOC - d->recus ? n : TAILLE_EN_TETE_BLOC - d->recus;
+			memcpy(d->bloc + d->recus, q, k);
+			d->recus += k;
+			q += k;
+			n -= k;
+			if (d->recus < TAILLE_EN_TETE_BLOC)
+			{
+				break;
+			}
+			d->taille = taille_bloc_flux(d->bloc);
+			if (d->taille == 0)
+			{
+				d->erreur = HUFF_ERREUR_DONNEES;
+				break;
+			}
+			if (d->taille > d->capacite_bloc)
+			{
+				uint8_t *bloc = realloc(d->bloc, d->taille);
+				if (bloc == NULL)
+				{
+					d->erreur = HUFF_ERREUR_MEMOIRE;
+					break;
+				}
+				d->bloc = bloc;
+				d->capacite_bloc = d->taille;
+			}
+		}
+		
+		size_t k = n < d->taille - d->recus ? n : d->taille - d->recus;
+		memcpy(d->bloc + d->recus, q, k);
+		d->recus += k;
+		q += k;
+		n -= k;
+		if (d->recus == d->taille)
+		{
+			decoder_bloc_flux(d, d->bloc, d->taille);
+			d->recus = 0;
+			d->fin = d->message; //le message court n'a qu'un bloc
+		}
+	}
+	return d->erreur;
+}
+
+//fonction pour terminer la décompression en flux : le marqueur de fin doit avoir été reçu
+int huff_decompresseur_terminer(huff_decompresseur *d)
+{
+	if (d->erreur == HUFF_OK && !d->fin)
+	{
+		d->erreur = HUFF_ERREUR_DONNEES; //données tronquées
+	}
+	return d->erreur;
+}
+
+//fonction pour libérer un décompresseur
+void huff_decompresseur_liberer(huff_decompresseur *d)
+{
+	if (d == NULL)
+	{
+		return;
+	}
+	free(d->bloc);
+	free(d->tampon);
+	free_table_courante(&d->tc);
+	free(d);
+}
+
+//fonction pour choisir si un membre d'un lot est codé avec la table commune : seulement si elle le code au plus aussi court
+//que ses propres codes avec leur en tête, estimés sur tout le membre comme s'il tenait dans un bloc
+static int table_commune_adaptee(const huff_dictionnaire *d, const uint8_t *donnees, size_t taille, int lg_max)
+{
+	uint64_t tab[256];
+	uint8_t longueurs[256];
+	uint8_t tete[EN_TETE_TAILLE_MAX];
+	apparitions(donnees, taille, tab);
+	if (taille == 0 || longueurs_bloc(tab, 256, lg_max, longueurs) != 0)
+	{
+		return 1;
+	}
+	return 4 + taille_codee(tab, 256, d->longueurs) <= taille_codee(tab, 256, longueurs) + en_tete(tete, longueurs);
+}
+
+//fonction exécutée par chaque thread d'un lot : on prend le prochain membre tant qu'il en reste. Pendant l'entraînement,
+//ses caractères sont ajoutés aux comptes du thread, sinon il est compressé dans un seul thread, avec un huff_contexte s'il est petit
+static void* thread_lot(void *arg)
+{
+	travail_lot *w = arg;
+	uint64_t comptes[256] = {0};
+	huff_contexte *ctx = NULL; //alloué au premier petit membre, puis réutilisé
+	huff_options o = *w->o;
+	o.nb_threads = 1; //les membres sont répartis entre les threads, pas leurs blocs
+	
+	for (;;)
+	{
+		pthread_mutex_lock(&w->verrou);
+		uint32_t i = w->erreur == HUFF_OK ? w->suivant++ : w->nb_membres;
+		pthread_mutex_unlock(&w->verrou);
+		if (i >= w->nb_membres)
+		{
+			break;
+		}
+		const huff_membre *m = &w->membres[i];
+		
+		if (w->a_entrainer != NULL)
+		{
+			uint64_t tab[256];
+			apparitions(m->donnees, m->taille, tab);
+			for (int c = 0; c < 256; c++)
+			{
+				comptes[c] += tab[c];
+			}
+			continue;
+		}
+		
+		o.dictionnaire = w->dictionnaire;
+		if (w->commun && !table_commune_adaptee(w->dictionnaire, m->donnees, m->taille, o.lg_max))
+		{
+			o.dictionnaire = NULL;
+		}
+		size_t t = huff_taille_max(m->taille, w->o);
+		int r;
+		if (huff_petit_possible(m->taille, &o))
+		{
+			if (ctx == NULL)
+			{
+				ctx = malloc(sizeof(huff_contexte));
+			}
+			r = ctx != NULL ? huff_compresser_petit(ctx, m->donnees, m->taille, w->dst + w->positions[i], &t, &o) : HUFF_ERREUR_MEMOIRE;
+		}
+		else
+		{
+			r = huff_compresser(m->donnees, m->taille, w->dst + w->positions[i], &t, &o);
+		}
+		w->tailles[i] = t;
+		
+		if (r != HUFF_OK)
+		{
+			pthread_mutex_lock(&w->verrou);
+			if (w->erreur == HUFF_OK)
+			{
+				w->erreur = r;
+			}
+			pthread_mutex_unlock(&w->verrou);
+		}
+	}
+	
+	if (w->a_entrainer != NULL)
+	{
+		pthread_mutex_lock(&w->verrou);
+		for (int c = 0; c < 256; c++)
+		{
+			w->a_entrainer->apparitions[c] += comptes[c];
+		}
+		pthread_mutex_unlock(&w->verrou);
+	}
+	free(ctx);
+	return NULL;
+}
+
+//fonction pour traiter tous les membres d'un lot avec au plus nb_threads threads, dans le thread appelant s'il n'en faut qu'un
+//ou si les threads n'ont pas pu être créés
+static int executer_lot(travail_lot *w, int nb_threads)
+{
+	w->suivant = 0;
+	if ((uint32_t)nb_threads > w->nb_membres) //inutile d'avoir plus de threads que de membres
+	{
+		nb_threads = w->nb_membres > 0 ? (int)w->nb_membres : 1;
+	}
+	pthread_t *threads = nb_threads > 1 ? malloc(nb_threads * sizeof(pthread_t)) : NULL;
+	int crees = 0;
+	while (threads != NULL && crees < nb_threads && pthread_create(&threads[crees], NULL, thread_lot, w) == 0)
+	{
+		crees++;
+	}
+	if (crees < nb_threads)
+	{
+		thread_lot(w);
+	}
+	for (int k = 0; k < crees; k++)
+	{
+		pthread_join(threads[k], NULL);
+	}
+	free(threads);
+	return w->erreur;
+}
+
+//fonction qui renvoie la taille maximale d'une archive : la place de chaque membre compressé seul, son entrée d'index et son nom
+size_t huff_lot_taille_max(const huff_membre *membres, size_t nb_membres, const huff_options *o)
+{
+	size_t taille = TAILLE_EN_TETE_LOT + HUFF_TAILLE_DICTIONNAIRE_MAX + TAILLE_PIED_LOT;
+	for (size_t i = 0; i < nb_membres; i++)
+	{
+		taille += huff_taille_max(membres[i].taille, o) + TAILLE_ENTREE_LOT + (membres[i].nom != NULL ? strlen(membres[i].nom) : 0);
+	}
+	return taille;
+}
+
+//fonction pour compresser un lot de zones en mémoire en une archive dans dst, qui doit avoir la place donnée par huff_lot_taille_max.
+//Les membres sont compressés en parallèle, chacun à une place réservée d'après huff_taille_max, puis rapprochés dans l'ordre.
+//Avec o->table_commune (sans dictionnaire dans les options), les caractères de tous les membres sont d'abord comptés en parallèle
+//pour entraîner un dictionnaire, que chaque membre n'utilise que s'il le code au moins aussi bien que ses propres codes.
+int huff_compresser_lot(const huff_membre *membres, size_t nb_membres, void *dst, size_t *taille_dst, const huff_options *o)
+{
+	uint8_t *sortie = dst;
+	if (!options_valides(o) || nb_membres > UINT32_MAX)
+	{
+		return HUFF_ERREUR_PARAMETRE;
+	}
+	if (*taille_dst < huff_lot_taille_max(membres, nb_membres, o))
+	{
+		return HUFF_ERREUR_PLACE;
+	}
+	
+	travail_lot w;
+	w.membres = membres;
+	w.nb_membres = (uint32_t)nb_membres;
+	w.dst = sortie;
+	w.o = o;
+	w.a_entrainer = NULL;
+	w.dictionnaire = o->dictionnaire;
+	w.commun = 0;
+	w.erreur = HUFF_OK;
+	pthread_mutex_init(&w.verrou, NULL);
+	
+	huff_dictionnaire *commun = NULL;
+	w.positions = malloc(2 * (nb_membres + 1) * sizeof(size_t));
+	if (w.positions == NULL)
+	{
+		pthread_mutex_destroy(&w.verrou);
+		return HUFF_ERREUR_MEMOIRE;
+	}
+	if (o->dictionnaire == NULL && o->table_commune && o->lg_max >= 8) //un dictionnaire donne un code à chacun des 256 caractères
+	{
+		commun = huff_dictionnaire_creer();
+		int entraine = HUFF_ERREUR_MEMOIRE;
+		if (commun != NULL)
+		{
+			w.a_entrainer = commun;
+			executer_lot(&w, o->nb_threads);
+			w.a_entrainer = NULL;
+			entraine = huff_dictionnaire_entrainer(commun, o->lg_max); //lg_max est valide : seule la table peut manquer
+		}
+		if (entraine != HUFF_OK)
+		{
+			huff_dictionnaire_liberer(commun);
+			free(w.positions);
+			pthread_mutex_destroy(&w.verrou);
+			return entraine;
+		}
+		w.dictionnaire = commun;
+		w.commun = 1;
+	}
+	
+	ecrire_u32(sortie, MAGIC_LOT);
+	sortie[4] = VERSION_LOT;
+	size_t taille_dictionnaire = w.dictionnaire != NULL ? huff_dictionnaire_ecrire(w.dictionnaire, sortie + TAILLE_EN_TETE_LOT) : 0;
+	sortie[5] = (uint8_t)taille_dictionnaire;
+	sortie[6] = (uint8_t)(taille_dictionnaire >> 8);
+	
+	w.tailles = w.positions + nb_membres + 1;
+	size_t position = TAILLE_EN_TETE_LOT + taille_dictionnaire;
+	for (size_t i = 0; i < nb_membres; i++)
+	{
+		w.positions[i] = position;
+		position += huff_taille_max(membres[i].taille, o);
+	}
+	
+	int r = executer_lot(&w, o->nb_threads);
+	if (r == HUFF_OK)
+	{
+		//les membres sont rapprochés dans l'ordre, chacun ne peut que reculer
+		position = TAILLE_EN_TETE_LOT + taille_dictionnaire;
+		for (size_t i = 0; i < nb_membres; i++)
+		{
+			memmove(sortie + position, sortie + w.positions[i], w.tailles[i]);
+			w.positions[i] = position;
+			position += w.tailles[i];
+		}
+		
+		size_t position_index = position;
+		size_t noms = position_index + nb_membres * TAILLE_ENTREE_LOT;
+		size_t fin_nom = 0;
+		for (size_t i = 0; i < nb_membres && r == HUFF_OK; i++)
+		{
+			size_t longueur = membres[i].nom != NULL ? strlen(membres[i].nom) : 0;
+			if (longueur > 0)
+			{
+				memcpy(sortie + noms + fin_nom, membres[i].nom, longueur);
+			}
+			fin_nom += longueur;
+			if (fin_nom > UINT32_MAX)
+			{
+				r = HUFF_ERREUR_PARAMETRE; //les noms ne tiennent pas dans l'index
+			}
+			uint8_t *entree = sortie + position_index + i * TAILLE_ENTREE_LOT;
+			ecrire_u64(entree, w.positions[i]);
+			ecrire_u64(entree + 8, w.tailles[i]);
+			ecrire_u64(entree + 16, membres[i].taille);
+			ecrire_u32(entree + 24, (uint32_t)fin_nom);
+		}
+		position = noms + fin_nom;
+		ecrire_u64(sortie + position, position_index);
+		ecrire_u32(sortie + position + 8, (uint32_t)nb_membres);
+		ecrire_u32(sortie + position + 12, MAGIC_LOT);
+		if (r == HUFF_OK)
+		{
+			*taille_dst = position + TAILLE_PIED_LOT;
+		}
+	}
+	
+	free(w.positions);
+	huff_dictionnaire_liberer(commun);
+	pthread_mutex_destroy(&w.verrou);
+	return r;
+}
+
+//fonction pour lire le pied d'une archive, elle renvoie la position de l'index ou 0 si l'archive est invalide
+static size_t lire_pied_lot(const uint8_t *p, size_t taille, uint32_t *nb_membres)
+{
+	if (taille < TAILLE_EN_TETE_LOT + TAILLE_PIED_LOT || lire_u32(p) != MAGIC_LOT || lire_u32(p + taille - 4) != MAGIC_LOT)
+	{
+		return 0;
+	}
+	size_t debut_membres = TAILLE_EN_TETE_LOT + (p[5] | (size_t)p[6] << 8);
+	uint64_t position_index = lire_u64(p + taille - TAILLE_PIED_LOT);
+	*nb_membres = lire_u32(p + taille - 8);
+	if (debut_membres > taille - TAILLE_PIED_LOT || position_index < debut_membres || position_index > taille - TAILLE_PIED_LOT
+		|| *nb_membres > (taille - TAILLE_PIED_LOT - position_index) / TAILLE_ENTREE_LOT)
+	{
+		return 0;
+	}
+	return position_index;
+}
+
+//fonction pour lire l'en tête et le pied d'une archive : nombre de membres et dictionnaire (NULL si l'archive n'en a pas)
+int huff_lot_lire(const void *src, size_t taille, uint32_t *nb_membres, huff_dictionnaire **dictionnaire)
+{
+	const uint8_t *p = src;
+	*dictionnaire = NULL;
+	if (taille >= TAILLE_EN_TETE_LOT && lire_u32(p) == MAGIC_LOT && p[4] != VERSION_LOT)
+	{
+		return HUFF_ERREUR_VERSION;
+	}
+	if (lire_pied_lot(p, taille, nb_membres) == 0)
+	{
+		return HUFF_ERREUR_DONNEES;
+	}
+	size_t taille_dictionnaire = p[5] | (size_t)p[6] << 8;
+	if (taille_dictionnaire > 0)
+	{
+		*dictionnaire = huff_dictionnaire_lire(p + TAILLE_EN_TETE_LOT, taille_dictionnaire);
+		if (*dictionnaire == NULL)
+		{
+			return HUFF_ERREUR_DONNEES;
+		}
+	}
+	return HUFF_OK;
+}
+
+//fonction pour lire l'entrée numéro i de l'index d'une archive : les positions sont vérifiées, pas les données du membre
+int huff_lot_membre(const void *src, size_t taille, uint32_t i, huff_info_membre *m)
+{
+	const uint8_t *p = src;
+	uint32_t nb_membres;
+	size_t position_index = lire_pied_lot(p, taille, &nb_membres);
+	if (position_index == 0)
+	{
+		return HUFF_ERREUR_DONNEES;
+	}
+	if (i >= nb_membres)
+	{
+		return HUFF_ERREUR_PARAMETRE;
+	}
+	
+	const uint8_t *entree = p + position_index + (size_t)i * TAILLE_ENTREE_LOT;
+	size_t noms = position_index + (size_t)nb_membres * TAILLE_ENTREE_LOT;
+	uint64_t position = lire_u64(entree);
+	uint64_t taille_membre = lire_u64(entree + 8);
+	uint64_t debut_nom = i > 0 ? lire_u32(entree - 4) : 0;
+	uint64_t fin_nom = lire_u32(entree + 24);
+	if (position < TAILLE_EN_TETE_LOT || position > position_index || taille_membre > position_index - position
+		|| debut_nom > fin_nom || fin_nom > taille - TAILLE_PIED_LOT - noms)
+	{
+		return HUFF_ERREUR_DONNEES;
+	}
+	m->donnees = p + position;
+	m->taille = taille_membre;
+	m->nom = (const char *)p + noms + debut_nom;
+	m->longueur_nom = fin_nom - debut_nom;
+	m->taille_originale = lire_u64(entree + 16);
+	return HUFF_OK;
+}
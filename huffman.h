@@ -0,0 +1,172 @@
+/*Projet Huffman - Compression et Décompression de fichiers en C
+Auteur : Rosselle QUIZON
+Description du code : Interface de la bibliothèque de compression de Huffman (libhuffman), utilisée par compresser.c et decompresser.c*/
+
+#ifndef HUFFMAN_H
+#define HUFFMAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//codes de retour des fonctions de la bibliothèque
+#define HUFF_OK 0
+#define HUFF_ERREUR_DONNEES -1 //données compressées corrompues ou tronquées
+#define HUFF_ERREUR_PLACE -2 //le tampon de sortie est trop petit
+#define HUFF_ERREUR_PARAMETRE -3 //option invalide
+#define HUFF_ERREUR_ECRITURE -4 //la fonction d'écriture fournie a échoué
+#define HUFF_ERREUR_DICTIONNAIRE -5 //les données ont été compressées avec un dictionnaire absent des options ou différent
+#define HUFF_ERREUR_VERSION -6 //les données ont été compressées avec une version du format non supportée
+#define HUFF_ERREUR_CONTEXTE -7 //les données demandent plus de place que n'en a un huff_contexte (modèle d'ordre 1, plages, codes de plus de 15 bits)
+#define HUFF_ERREUR_MEMOIRE -8 //une allocation a échoué
+
+#define HUFF_LONGUEUR_MAX 32 //un code Huffman doit tenir dans 32 bits
+#define HUFF_LONGUEUR_DEFAUT 15 //longueur maximale des codes par défaut
+#define HUFF_TAILLE_BLOC_DEFAUT ((size_t)1 << 20) //taille des blocs de l'entrée par défaut
+#define HUFF_TAILLE_BLOC_MAX ((size_t)1 << 30)
+#define HUFF_TAILLE_DICTIONNAIRE_MAX (4 + 1 + 256) //identifiant puis en tête des longueurs
+#define HUFF_TAILLE_EN_TETE 13 //en tête du fichier : magique, version puis taille d'origine
+#define HUFF_TAILLE_INCONNUE UINT64_MAX //taille d'origine non annoncée dans l'en tête
+#ifndef HUFF_PETIT_MAX
+#define HUFF_PETIT_MAX ((size_t)1 << 16) //taille en dessous de laquelle les programmes passent par huff_contexte (modifiable à la compilation)
+#endif
+#define HUFF_TAILLE_CONTEXTE (56 * 1024) //taille d'un huff_contexte en octets
+#define HUFF_LONGUEUR_CONTEXTE 15 //longueur maximale des codes compressés ou décompressés avec un huff_contexte
+
+//dictionnaire : table de codes entraînée sur des échantillons, partagée par la compression et la décompression
+typedef struct huff_dictionnaire huff_dictionnaire;
+
+//phases mesurées dans huff_stats
+#define HUFF_PHASE_HISTOGRAMME 0 //comptage des caractères et échantillonnage des blocs incompressibles
+#define HUFF_PHASE_ARBRE 1 //arbre, longueurs des codes et choix du codage de chaque bloc
+#define HUFF_PHASE_CODAGE 2 //codes canoniques, codage des données et CRC
+#define HUFF_PHASE_TABLES 3 //lecture des longueurs et construction des tables de décodage
+#define HUFF_PHASE_DECODAGE 4 //décodage des données et vérification du CRC
+#define HUFF_PHASE_ECRITURE 5 //appels à la fonction d'écriture de l'appelant
+#define HUFF_NB_PHASES 6
+
+//mesures d'une compression ou d'une décompression, ajoutées à celles déjà présentes : à mettre à zéro avant la première.
+//Les temps sont additionnés sur tous les threads. Les caractères comptés sont ceux des blocs codés avec des codes Huffman.
+typedef struct {
+	uint64_t ns_reel[HUFF_NB_PHASES]; //temps écoulé dans chaque phase, en nanosecondes
+	uint64_t ns_cpu[HUFF_NB_PHASES]; //temps processeur des threads dans chaque phase
+	uint64_t octets_entree; //compression : données d'origine, décompression : blocs compressés
+	uint64_t octets_sortie;
+	uint64_t blocs;
+	uint64_t caracteres; //caractères codés ou décodés avec des codes Huffman
+	uint64_t bits; //bits de leurs codes (décompression : octets des données codées)
+	double entropie; //compression : entropie de ces caractères en bits, bloc par bloc, d'ordre 0 (d'ordre 1 pour les blocs codés par contexte)
+	uint32_t lg_max; //longueur du plus long code utilisé
+	uint64_t ecritures; //appels à la fonction d'écriture
+} huff_stats;
+
+//options de compression et de décompression
+typedef struct {
+	size_t taille_bloc; //taille des blocs compressés indépendamment
+	int lg_max; //longueur maximale des codes Huffman
+	int nb_threads; //1 : tout se fait dans le thread appelant
+	int arbre; //décompression : décodage de référence bit par bit en parcourant l'arbre
+	const huff_dictionnaire *dictionnaire; //si non NULL, les blocs sont codés avec ses codes, sans table dans les blocs
+	int nb_flux; //compression : 1, ou 4 flux entrelacés par bloc pour un décodage plus rapide (défaut)
+	huff_stats *stats; //si non NULL, les mesures de chaque compression ou décompression y sont ajoutées
+	int ordre; //compression : 0 (défaut), ou 1 pour coder chaque caractère avec une table choisie d'après le caractère précédent (sans dictionnaire)
+	int plages; //compression : 1 pour essayer de coder les plages de caractères répétés par leur longueur (sans dictionnaire)
+	int table_commune; //compression d'un lot : 1 pour entraîner un dictionnaire sur tous les membres, utilisé par ceux qu'il code bien
+} huff_options;
+
+//fonction d'écriture fournie par l'appelant : elle renvoie 0, ou une autre valeur en cas d'erreur
+typedef int (*huff_ecrire)(void *ctx, const void *p, size_t n);
+//fonction d'écriture à une position donnée de la sortie, les blocs décodés en parallèle arrivent dans le désordre
+typedef int (*huff_ecrire_a)(void *ctx, const void *p, size_t n, uint64_t position);
+
+//fonction pour remplir les options avec les valeurs par défaut
+void huff_options_defaut(huff_options *o);
+//fonction qui renvoie le message d'erreur correspondant à un code de retour
+const char* huff_erreur(int code);
+//fonction pour écrire les mesures en une ligne JSON (sans retour à la ligne) dans dst, elle renvoie la longueur comme snprintf
+int huff_stats_json(const huff_stats *s, char *dst, size_t taille);
+
+//compression d'une zone en mémoire : taille_max donne une borne de la taille compressée pour dimensionner dst,
+//*taille_dst contient la place disponible dans dst et reçoit la taille compressée. Avec un dictionnaire, des données qui tiennent
+//dans un bloc sont écrites en message court (un seul bloc, sans index ni pied), lu par toutes les fonctions de décompression.
+size_t huff_taille_max(size_t taille, const huff_options *o);
+int huff_compresser(const void *src, size_t taille, void *dst, size_t *taille_dst, const huff_options *o);
+
+//décompression d'une zone en mémoire : taille_originale lit la taille des données d'origine dans l'index des blocs
+int huff_taille_originale(const void *src, size_t taille, uint64_t *taille_originale);
+//lecture de l'en tête seul, les HUFF_TAILLE_EN_TETE premiers octets suffisent : *taille_originale peut valoir HUFF_TAILLE_INCONNUE
+int huff_lire_en_tete(const void *src, size_t taille, uint64_t *taille_originale);
+int huff_decompresser(const void *src, size_t taille, void *dst, size_t *taille_dst, const huff_options *o);
+//comme huff_decompresser, mais chaque bloc décodé est passé à ecrire avec sa position dans les données d'origine
+int huff_decompresser_vers(const void *src, size_t taille, huff_ecrire_a ecrire, void *ctx, const huff_options *o);
+//décompression de *longueur octets des données d'origine à partir de debut, *longueur est ramené à la fin des données
+int huff_decompresser_intervalle(const void *src, size_t taille, uint64_t debut, size_t *longueur, void *dst, const huff_options *o);
+
+//dictionnaire : on ajoute des échantillons puis on l'entraîne, ou on le lit tel qu'il a été écrit après l'entraînement.
+//Il n'est pas modifié par la compression ni la décompression, plusieurs threads peuvent l'utiliser à la fois.
+//huff_dictionnaire_creer renvoie NULL si l'allocation échoue, huff_dictionnaire_lire si le dictionnaire est invalide ou si l'allocation échoue.
+huff_dictionnaire* huff_dictionnaire_creer(void);
+void huff_dictionnaire_ajouter(huff_dictionnaire *d, const void *echantillon, size_t taille);
+int huff_dictionnaire_entrainer(huff_dictionnaire *d, int lg_max);
+size_t huff_dictionnaire_ecrire(const huff_dictionnaire *d, void *dst);
+huff_dictionnaire* huff_dictionnaire_lire(const void *src, size_t taille);
+uint32_t huff_dictionnaire_id(const huff_dictionnaire *d);
+void huff_dictionnaire_liberer(huff_dictionnaire *d);
+
+//compression et décompression sans allocation ni thread, pour les petits messages : tout l'état (apparitions, longueurs, codes
+//et table de décodage) est dans un huff_contexte que l'appelant place sur la pile ou réutilise d'un appel à l'autre.
+//La compression écrit un seul bloc : taille ne doit pas dépasser o->taille_bloc, dst doit avoir la place donnée par huff_taille_max,
+//et les codes sont limités à HUFF_LONGUEUR_CONTEXTE bits (o->ordre, o->plages et o->nb_threads sont ignorés). La décompression lit
+//les données de huff_compresser et huff_compresseur, sauf les blocs du modèle d'ordre 1, des plages ou avec des codes plus longs.
+typedef struct {
+	uint64_t prive[HUFF_TAILLE_CONTEXTE / 8]; //réservé à huffman.c, aucune initialisation n'est nécessaire
+} huff_contexte;
+//huff_petit_possible renvoie 1 si taille octets peuvent passer par huff_compresser_petit avec ces options au lieu de huff_compresser :
+//au plus HUFF_PETIT_MAX octets dans un bloc, codes d'au plus HUFF_LONGUEUR_CONTEXTE bits, sans ordre 1 ni plages sauf avec un dictionnaire.
+int huff_petit_possible(size_t taille, const huff_options *o);
+int huff_compresser_petit(huff_contexte *ctx, const void *src, size_t taille, void *dst, size_t *taille_dst, const huff_options *o);
+int huff_decompresser_petit(huff_contexte *ctx, const void *src, size_t taille, void *dst, size_t *taille_dst, const huff_options *o);
+
+//lot : plusieurs zones compressées en une seule archive, sur un groupe de o->nb_threads threads qui prennent chacun le prochain membre.
+//Chaque membre est un fichier compressé complet (huff_compresser, ou huff_compresser_petit s'il est petit, en message court s'il est
+//codé avec le dictionnaire), suivi d'un index des membres
+//avec leurs noms. Le dictionnaire des options, ou la table commune entraînée avec o->table_commune, est écrit dans l'archive.
+typedef struct {
+	const void *donnees;
+	size_t taille;
+	const char *nom; //chaîne terminée par un zéro écrite dans l'index, ou NULL
+} huff_membre;
+//membre lu dans l'index d'une archive : donnees pointe sur ses données compressées, à passer à huff_decompresser avec le dictionnaire de l'archive
+typedef struct {
+	const void *donnees;
+	size_t taille;
+	const char *nom; //sans zéro final
+	size_t longueur_nom;
+	uint64_t taille_originale;
+} huff_info_membre;
+size_t huff_lot_taille_max(const huff_membre *membres, size_t nb_membres, const huff_options *o);
+int huff_compresser_lot(const huff_membre *membres, size_t nb_membres, void *dst, size_t *taille_dst, const huff_options *o);
+//lecture de l'en tête et de l'index : *dictionnaire reçoit le dictionnaire de l'archive (NULL si elle n'en a pas), à libérer par l'appelant
+int huff_lot_lire(const void *src, size_t taille, uint32_t *nb_membres, huff_dictionnaire **dictionnaire);
+int huff_lot_membre(const void *src, size_t taille, uint32_t i, huff_info_membre *m);
+
+//compression en flux : les données sont passées par morceaux de taille quelconque, le résultat est passé à ecrire.
+//huff_compresseur_creer renvoie NULL si les options sont invalides ou si l'allocation échoue.
+typedef struct huff_compresseur huff_compresseur;
+huff_compresseur* huff_compresseur_creer(const huff_options *o, huff_ecrire ecrire, void *ctx);
+//annonce la taille totale des données avant le premier morceau, elle est écrite dans l'en tête et vérifiée à la fin
+int huff_compresseur_taille_totale(huff_compresseur *c, uint64_t taille);
+int huff_compresseur_ecrire(huff_compresseur *c, const void *p, size_t n);
+//sans copie : les blocs complets sont compressés directement dans p, qui doit rester valide jusqu'à huff_compresseur_terminer
+int huff_compresseur_ecrire_sans_copie(huff_compresseur *c, const void *p, size_t n);
+int huff_compresseur_terminer(huff_compresseur *c);
+void huff_compresseur_liberer(huff_compresseur *c);
+
+//décompression en flux : les données compressées sont passées par morceaux, les données d'origine sont passées à ecrire.
+//huff_decompresseur_creer renvoie NULL si l'allocation échoue.
+typedef struct huff_decompresseur huff_decompresseur;
+huff_decompresseur* huff_decompresseur_creer(const huff_options *o, huff_ecrire ecrire, void *ctx);
+int huff_decompresseur_ecrire(huff_decompresseur *d, const void *p, size_t n);
+int huff_decompresseur_terminer(huff_decompresseur *d);
+void huff_decompresseur_liberer(huff_decompresseur *d);
+
+#endif
@@ -0,0 +1,62 @@
+/*Projet Huffman - Compression et Décompression de fichiers en C
+Auteur : Rosselle QUIZON
+Description du code : Fonctions communes aux programmes compresser et decompresser, autour de la bibliothèque huffman.c*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "outils.h"
+
+//fonction pour lire un fichier dictionnaire écrit par compresser --entrainer, le programme s'arrête s'il est absent ou invalide
+huff_dictionnaire* charger_dictionnaire(const char *fichier)
+{
+	uint8_t tampon[HUFF_TAILLE_DICTIONNAIRE_MAX + 1];
+	FILE *f = fopen(fichier, "rb");
+	if (f == NULL)
+	{
+		fprintf(stderr, "Erreur : impossible d'ouvrir le dictionnaire %s\n", fichier);
+		exit(EXIT_FAILURE);
+	}
+	size_t taille = fread(tampon, 1, sizeof(tampon), f);
+	fclose(f);
+	
+	huff_dictionnaire *d = huff_dictionnaire_lire(tampon, taille);
+	if (d == NULL)
+	{
+		fprintf(stderr, "Erreur : le fichier %s n'est pas un dictionnaire valide.\n", fichier);
+		exit(EXIT_FAILURE);
+	}
+	return d;
+}
+
+//fonction pour écrire sur la sortie d'erreur une ligne JSON avec les mesures de la bibliothèque et celles du processus : temps écoulé,
+//temps processeur, pic de mémoire et nombre d'appels système de lecture et d'écriture, lus dans /proc/self/io (-1 s'il n'existe pas)
+void afficher_stats(const char *programme, const huff_stats *s, const struct timespec *debut)
+{
+	struct timespec fin;
+	clock_gettime(CLOCK_MONOTONIC, &fin);
+	struct rusage u;
+	getrusage(RUSAGE_SELF, &u);
+	long long lectures = -1, ecritures = -1;
+	FILE *f = fopen("/proc/self/io", "r");
+	if (f != NULL)
+	{
+		char ligne[128];
+		while (fgets(ligne, sizeof(ligne), f) != NULL)
+		{
+			sscanf(ligne, "syscr: %lld", &lectures);
+			sscanf(ligne, "syscw: %lld", &ecritures);
+		}
+		fclose(f);
+	}
+	
+	char bibliotheque[2048];
+	huff_stats_json(s, bibliotheque, sizeof(bibliotheque));
+	fprintf(stderr, "{\"programme\": \"%s\", \"reel_s\": %.6f, \"cpu_utilisateur_s\": %.6f, \"cpu_systeme_s\": %.6f, \"rss_max_ko\": %ld, "
+		"\"appels_lecture\": %lld, \"appels_ecriture\": %lld, \"bibliotheque\": %s}\n", programme,
+		(fin.tv_sec - debut->tv_sec) + (fin.tv_nsec - debut->tv_nsec) * 1e-9, u.ru_utime.tv_sec + u.ru_utime.tv_usec * 1e-6,
+		u.ru_stime.tv_sec + u.ru_stime.tv_usec * 1e-6, u.ru_maxrss, lectures, ecritures, bibliotheque);
+}
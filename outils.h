@@ -0,0 +1,15 @@
+/*Projet Huffman - Compression et Décompression de fichiers en C
+Auteur : Rosselle QUIZON
+Description du code : Fonctions communes aux programmes compresser et decompresser (outils.c)*/
+
+#ifndef OUTILS_H
+#define OUTILS_H
+
+#include <time.h>
+
+#include "huffman.h"
+
+huff_dictionnaire* charger_dictionnaire(const char *fichier);
+void afficher_stats(const char *programme, const huff_stats *s, const struct timespec *debut);
+
+#endif